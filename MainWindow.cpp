@@ -125,6 +125,7 @@ void MainWindow::initPieMenu()
     pie_menu = new PieMenu(ui->centralwidget);
     pie_menu->setCloseButtonIcon(QIcon(":/icons/close-line-icon.png"));
     pie_menu->setPinButtonIcon(QIcon(":/icons/pushpin-icon.png"));
+    pie_menu->setProgressiveGeometry(true);
 
     emit this->ui->stroke_width_slider->valueChanged(5);
     emit this->ui->button_count_slider->valueChanged(4);
@@ -143,9 +144,18 @@ void MainWindow::initPieMenu()
 
 MainWindow::~MainWindow()
 {
+    if (!trace_file.isEmpty() && !pie_menu->trace().save(trace_file)) {
+        qWarning() << "Could not write trace file" << trace_file;
+    }
     delete ui;
 }
 
+void MainWindow::setTraceFile(const QString& path)
+{
+    trace_file = path;
+    pie_menu->setTraceRecording(!trace_file.isEmpty());
+}
+
 void MainWindow::mouseReleaseEvent(QMouseEvent *event)
 {
     if (event->button() == Qt::RightButton) {
@@ -38,6 +38,10 @@ public:
     ~MainWindow(void) override;
     
     void loadTheme(QFile file);
+
+    /// \brief Records the pie menu events and writes them to a trace file on exit
+    /// \param path: Reference to the path of the trace file
+    void setTraceFile(const QString& path);
     
 protected:
     /// \brief Overridden event handler to open the pie menu
@@ -53,5 +57,8 @@ protected:
 
     /// \brief Pointer to the pie menu widget
     PieMenu *pie_menu = nullptr;
+
+    /// \brief Path of the trace file written on exit, empty if not recording
+    QString trace_file;
 };
 #endif // MAINWINDOW_H
@@ -20,46 +20,281 @@
 #include <QApplication>
 #include <QPushButton>
 #include <QMouseEvent>
+#include <QTouchEvent>
+#include <QTabletEvent>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtAlgorithms>
+
+#ifdef PIEMENU_COUNT_ALLOCATIONS
+namespace {
+    /// \brief Whether heap allocations on this thread are currently counted
+    thread_local bool count_allocations = false;
+
+    /// \brief The amount of heap allocations counted on this thread
+    thread_local quint64 counted_allocations = 0;
+}
+
+void PieMenu::countAllocation() noexcept {
+    if (count_allocations) {
+        counted_allocations++;
+    }
+}
+#endif
+
+namespace {
+    /// \brief Counts the heap allocations of the current thread during its lifetime
+    /// Always counts zero unless PIEMENU_COUNT_ALLOCATIONS is defined
+    class AllocationCounter {
+    public:
+#ifdef PIEMENU_COUNT_ALLOCATIONS
+        AllocationCounter() : start(counted_allocations), counting(count_allocations) { count_allocations = true; }
+        ~AllocationCounter() { count_allocations = counting; }
+        quint64 allocations() const { return counted_allocations - start; }
+    private:
+        quint64 start;
+        bool counting;
+#else
+        quint64 allocations() const { return 0; }
+#endif
+    };
+
+    /// \brief Excludes the heap allocations of the current thread during its lifetime
+    /// from all active AllocationCounters
+    class AllocationExclusion {
+    public:
+#ifdef PIEMENU_COUNT_ALLOCATIONS
+        AllocationExclusion() : counting(count_allocations) { count_allocations = false; }
+        ~AllocationExclusion() { count_allocations = counting; }
+    private:
+        bool counting;
+#else
+        AllocationExclusion() {}
+#endif
+    };
+
+    /// \brief Carries a queued button click to the event loop
+    /// Posted below Qt::LowEventPriority, so the update request of the click is flushed first
+    class ButtonClickEvent : public QEvent {
+    public:
+        ButtonClickEvent(uint8_t index, quint64 frame) : QEvent(eventType()), index(index), frame(frame) {}
+
+        static QEvent::Type eventType() {
+            static const auto type = static_cast<QEvent::Type>(QEvent::registerEventType());
+            return type;
+        }
+
+        /// \brief The index of the clicked button
+        const uint8_t index;
+        /// \brief The amount of painted button frames when the button was clicked
+        const quint64 frame;
+    };
+}
 
 PieMenu::PieMenu(QWidget *parent):
     QWidget(parent),
     default_button_icons{button_count, QIcon()},
     disabled_button_icons{button_count, QIcon()},
+    button_texts(button_count),
+    button_labels(button_count),
+    button_label_positions(button_count),
     pie_button_paths{button_count, QPainterPath()},
-    buttons_enabled(button_count, true),
-    angle_per_button(360.0f / button_count),
+    buttons_enabled(button_count, 1),
+    buttons_busy(button_count, 0),
+    button_actions(button_count),
+    rings{Ring{button_count}},
+    button_rings(button_count, 0),
     close_button_index(button_count + 1),
     pin_button_index(button_count + 2) {
 
     applyGeometry();
     setMouseTracking(true);
+    setAttribute(Qt::WA_AcceptTouchEvents);
     hide();
 
+    live_flush_timer.setSingleShot(true);
+    QObject::connect(&live_flush_timer, &QTimer::timeout, this, &PieMenu::flushLiveData);
+
+    settle_timer.setSingleShot(true);
+    QObject::connect(&settle_timer, &QTimer::timeout, this, &PieMenu::finishGeometryChange);
+
+    pointer_rest_timer.setSingleShot(true);
+    QObject::connect(&pointer_rest_timer, &QTimer::timeout, this, &PieMenu::restPointer);
+
     initPainterPaths();
+    initBrushes();
+    initPixmaps();
+}
+
+void PieMenu::initBrushes() {
+    for (uint32_t flag = NORMAL; flag <= BUSY; flag <<= 1) {
+        brushes[qCountTrailingZeroBits(flag)] = createBrush(static_cast<RenderFlag>(flag));
+    }
+
+    stroke_pen = QPen(getBrush(STROKE), stroke_width);
+    hot_path_warm = false;
+}
+
+void PieMenu::initPixmaps() {
+    button_pixmaps.resize(button_count);
+    disabled_button_pixmaps.resize(button_count);
+
+    for (uint8_t i = 0; i < button_count; i++) {
+        button_pixmaps[i] = default_button_icons[i].pixmap(pie_icon_size, pie_icon_size);
+        disabled_button_pixmaps[i] = disabled_button_icons[i].pixmap(pie_icon_size, pie_icon_size);
+    }
+
+    close_pixmap = close_icon.pixmap(close_icon_size, close_icon_size);
+    pin_pixmap = pin_icon.pixmap(pin_icon_size, pin_icon_size);
+    hot_path_warm = false;
+}
+
+void PieMenu::initRingLayout() {
+    // a close button reaching over the pie would otherwise give rings of zero or negative width
+    const qreal thickness = qMax<qreal>((qreal(pie_radius) - close_button_radius) / rings.size(), 1);
+
+    ring_layouts.clear();
+    uint8_t first_index = 0;
+
+    for (const auto& ring : rings) {
+        RingLayout layout;
+        layout.first_index = first_index;
+        layout.count = ring.count;
+        layout.angle_per_button = 360.0f / ring.count;
+        layout.base_angle = base_angle + ring.angle_offset;
+        layout.inner_radius = close_button_radius + thickness * ring_layouts.size();
+        layout.outer_radius = layout.inner_radius + thickness;
+        layout.icon_radius = (layout.inner_radius + layout.outer_radius) / 2;
+
+        ring_layouts.push_back(layout);
+        first_index += ring.count;
+    }
+
+    if (ring_layouts.size() == 1) {
+        // the original single ring icon placement
+        ring_layouts[0].icon_radius = (pie_radius + (close_button_radius + stroke_width / 2.0f) / 2.0f - pie_icon_size / 2.0f) * 2.0f / 3.0f;
+    }
 }
 
 void PieMenu::initPainterPaths() {
+    initRingLayout();
+
+    const QPointF center(full_size.width() / 2.0f, full_size.height() / 2.0f);
+
+    for (const auto& ring : ring_layouts) {
+        const QRectF outer_rect(center.x() - ring.outer_radius, center.y() - ring.outer_radius, ring.outer_radius * 2, ring.outer_radius * 2);
+        const QRectF inner_rect(center.x() - ring.inner_radius, center.y() - ring.inner_radius, ring.inner_radius * 2, ring.inner_radius * 2);
+
+        for (uint8_t j = 0; j < ring.count; j++) {
+            QPainterPath path;
+
+            qreal angle = ring.angle_per_button * (j - 1) + ring.base_angle;
+
+            if (ring.first_index == 0) {
+                // the innermost ring is a plain pie slice, the close button covers its tip
+                path.moveTo(center);
+                path.arcTo(outer_rect, -angle, ring.angle_per_button);
+            }
+            else {
+                path.arcMoveTo(outer_rect, -angle);
+                path.arcTo(outer_rect, -angle, ring.angle_per_button);
+                path.arcTo(inner_rect, -angle + ring.angle_per_button, -ring.angle_per_button);
+                path.closeSubpath();
+            }
+
+            pie_button_paths[ring.first_index + j] = path;
+        }
+    }
+
     for (uint8_t i = 0; i < button_count; i++) {
-        QPainterPath path;
+        initProgressPath(i);
+        initBadgeRect(i);
+    }
 
-        qreal angle = angle_per_button * (i - 1) + base_angle;
+    hot_path_warm = false;
+    initLabelPositions();
+}
+
+qreal PieMenu::buttonCenterAngle(uint8_t index) const {
+    const auto& ring = ring_layouts[button_rings[index]];
 
-        path.moveTo(full_size.width() / 2.0f, full_size.height() / 2.0f);
+    return ring.angle_per_button * (index - ring.first_index - 1.5f) + ring.base_angle;
+}
 
-        path.arcTo(QRectF(stroke_width, stroke_width, full_size.width() - stroke_width * 2,
-                          full_size.height() - stroke_width * 2), -angle, angle_per_button);
+void PieMenu::initLabelLayout() {
+    const QFontMetricsF metrics(font());
 
-        pie_button_paths[i] = path;
+    for (uint8_t i = 0; i < button_count; i++) {
+        initLabel(i, metrics);
     }
+
+    hot_path_warm = false;
+
+    initLabelPositions();
+}
+
+void PieMenu::initLabel(uint8_t index, const QFontMetricsF& metrics) {
+    const auto& ring = ring_layouts[button_rings[index]];
+
+    // labels get the chord of the button at the icon radius, minus some padding
+    const qreal available_width = qMax<qreal>(2 * ring.icon_radius * qSin(qDegreesToRadians(qMin<qreal>(ring.angle_per_button, 180) / 2)) - 8, 1);
+
+    if (button_texts[index].isEmpty()) {
+        button_labels[index] = QStaticText();
+        return;
+    }
+
+    QStaticText label;
+    label.setTextFormat(Qt::PlainText);
+    label.setTextOption(QTextOption(Qt::AlignHCenter));
+
+    const auto wrapped = metrics.boundingRect(QRectF(0, 0, available_width, INT_MAX), Qt::TextWordWrap, button_texts[index]);
+
+    if (wrapped.height() <= metrics.lineSpacing() * 2 && wrapped.width() <= available_width) {
+        label.setText(button_texts[index]);
+        label.setTextWidth(available_width);
+    }
+    else {
+        label.setText(metrics.elidedText(button_texts[index], Qt::ElideRight, available_width));
+    }
+
+    label.prepare(QTransform(), font());
+    button_labels[index] = label;
+}
+
+void PieMenu::initLabelPositions() {
+    for (uint8_t i = 0; i < button_count; i++) {
+        initLabelPosition(i);
+    }
+}
+
+void PieMenu::initLabelPosition(uint8_t index) {
+    const auto label_size = button_labels[index].size();
+    auto center = buttonCenterPoint(index, ring_layouts[button_rings[index]].icon_radius);
+
+    if (!default_button_icons[index].isNull()) {
+        // keep the label clear of the button icon
+        center.ry() += (pie_icon_size + label_size.height()) / 2;
+    }
+
+    button_label_positions[index] = center - QPointF(label_size.width() / 2, label_size.height() / 2);
 }
 
 void PieMenu::display() {
+    display(QCursor::pos());
+}
+
+void PieMenu::display(const QPoint& global_position) {
     auto geometry_adjusted = geometry();
-    auto mapped_position = mapToParent(mapFromGlobal(QCursor::pos()));
+    auto mapped_position = mapToParent(mapFromGlobal(global_position));
 
     geometry_adjusted.setTopLeft(mapped_position - QPoint(full_size.width() / 2, full_size.height() / 2));
     setGeometry(geometry_adjusted);
 
+    pointer_position = mapFromGlobal(global_position);
+    pointer_velocity = QPointF();
+    pointer_clock.invalidate();
+
     show();
     setFocus();
 }
@@ -71,43 +306,102 @@ void PieMenu::hideIfNotPinned() {
 }
 
 void PieMenu::setButtonCount(uint8_t count) {
+    setRings({Ring{count}});
+}
+
+void PieMenu::setRings(const std::vector<Ring>& new_rings) {
+    if (geometry_settling) {
+        settle_timer.stop();
+        finishGeometryChange();
+    }
+
+    uint32_t count = 0;
+
+    for (const auto& ring : new_rings) {
+        if (ring.count == 0) {
+            throw std::invalid_argument("Could not set pie menu rings: empty ring");
+        }
+        count += ring.count;
+    }
+
+    // button indices including the close and pin/unpin button must fit into int8_t
+    if (new_rings.empty() || count > INT8_MAX - 2) {
+        throw std::invalid_argument("Could not set pie menu rings");
+    }
+
+    rings = new_rings;
     button_count = count;
 
+    button_rings.clear();
+    for (uint8_t r = 0; r < rings.size(); r++) {
+        button_rings.insert(button_rings.end(), rings[r].count, r);
+    }
+
     default_button_icons.resize(button_count);
     disabled_button_icons.resize(button_count);
     pie_button_paths.resize(button_count);
+    button_texts.resize(button_count);
+    button_labels.resize(button_count);
+    button_label_positions.resize(button_count);
 
     close_button_index = button_count + 1;
     pin_button_index = button_count + 2;
 
-    angle_per_button = 360.0f / button_count;
-
-    buttons_enabled.resize(button_count, true);
+    buttons_enabled.resize(button_count, 1);
+    buttons_busy.resize(button_count, 0);
+    button_actions.resize(button_count);
 
     initPainterPaths();
+    initLabelLayout();
+    initPixmaps();
+    recordTraceConfiguration();
 }
 
 void PieMenu::setBaseAngle(int32_t angle) {
+    const bool deferred = beginGeometryChange();
     base_angle = angle;
+    recordTraceConfiguration();
+
+    if (deferred) {
+        updateDeferredGeometry();
+        return;
+    }
     initPainterPaths();
 }
 
 void PieMenu::setStrokeWidth(int32_t value) {
+    const bool deferred = beginGeometryChange();
     stroke_width = value;
     applyGeometry();
+    recordTraceConfiguration();
+
+    if (deferred) {
+        updateDeferredGeometry();
+        return;
+    }
     initPainterPaths();
+    initLabelLayout();
+    initBrushes();
 }
 
 void PieMenu::setCloseButtonRadius(uint32_t radius) {
     close_button_radius = radius;
+    initPainterPaths();
+    initLabelLayout();
+    recordTraceConfiguration();
 }
 
 void PieMenu::setPinButtonRadius(uint32_t radius) {
     pin_button_radius = radius;
+    recordTraceConfiguration();
 }
 
 void PieMenu::setPieButtonIconSize(uint8_t size) {
     pie_icon_size = size;
+    initPainterPaths();
+    initLabelLayout();
+    initPixmaps();
+    recordTraceConfiguration();
 }
 
 void PieMenu::applyGeometry()
@@ -120,34 +414,315 @@ void PieMenu::applyGeometry()
 }
 
 void PieMenu::setPieRadius(int32_t value) {
+    const bool deferred = beginGeometryChange();
     pie_radius = value;
     applyGeometry();
+    recordTraceConfiguration();
 
+    if (deferred) {
+        updateDeferredGeometry();
+        return;
+    }
     initPainterPaths();
+    initLabelLayout();
+    initBrushes();
     update();
     repaint();
 }
 
+bool PieMenu::beginGeometryChange() {
+    if (!progressive_geometry || !isVisible()) {
+        return false;
+    }
+
+    if (!geometry_settling) {
+        // keep the last full render, later changes are previewed by transforming it
+        const qreal pixel_ratio = devicePixelRatioF();
+        geometry_snapshot = QPixmap(full_size * pixel_ratio);
+        geometry_snapshot.setDevicePixelRatio(pixel_ratio);
+        geometry_snapshot.fill(Qt::transparent);
+
+        // the pin button keeps its corner, it is painted on top of the snapshot
+        const bool pin_shown = show_pin_button;
+        show_pin_button = false;
+        // without DrawWindowBackground, the snapshot stays transparent outside the pie
+        render(&geometry_snapshot, QPoint(), QRegion(), QWidget::DrawChildren);
+        show_pin_button = pin_shown;
+
+        snapshot_angle = base_angle;
+        geometry_settling = true;
+    }
+
+    settle_timer.start(settle_time);
+    return true;
+}
+
+void PieMenu::updateDeferredGeometry() {
+    // hit-testing stays exact, only the painting is deferred
+    initRingLayout();
+    update();
+}
+
+void PieMenu::finishGeometryChange() {
+    geometry_settling = false;
+    geometry_snapshot = QPixmap();
+
+    initPainterPaths();
+    initLabelLayout();
+    initBrushes();
+    update();
+}
+
+void PieMenu::paintGeometrySnapshot(QPainter& painter) {
+    const QSizeF snapshot_logical_size = QSizeF(geometry_snapshot.size()) / geometry_snapshot.devicePixelRatio();
+    const qreal scale = qreal(full_size.width()) / snapshot_logical_size.width();
+
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, current_quality != MINIMAL_QUALITY);
+    painter.translate(full_size.width() / 2.0f, full_size.height() / 2.0f);
+    painter.rotate(base_angle - snapshot_angle);
+    painter.scale(scale, scale);
+    painter.drawPixmap(QPointF(-snapshot_logical_size.width() / 2, -snapshot_logical_size.height() / 2), geometry_snapshot);
+    painter.resetTransform();
+
+    if (show_pin_button) {
+        paintPinButton(painter, getButtonUnderMouse() == pin_button_index);
+    }
+}
+
 void PieMenu::setAlternateColors(bool value) {
     alternate_colors = value;
+    recordTraceConfiguration();
 }
 void PieMenu::setCloseButtonIconSize(uint8_t size) {
     close_icon_size = size;
+    initPixmaps();
+    recordTraceConfiguration();
 }
 
 void PieMenu::setPinButtonIconSize(uint8_t size) {
     pin_icon_size = size;
+    initPixmaps();
+    recordTraceConfiguration();
 }
 
 void PieMenu::setButtonEnabled(uint8_t index, bool enable) {
     if (index < buttons_enabled.size()) {
         buttons_enabled[index] = enable;
+        recordTraceConfiguration();
     }
     else {
         throw std::invalid_argument("Could not set pie menu button enable state");
     }
 }
 
+void PieMenu::setButtonAction(uint8_t index, std::function<void()> action) {
+    if (index < button_actions.size()) {
+        button_actions[index] = std::move(action);
+    }
+    else {
+        throw std::invalid_argument("Could not set pie menu button action");
+    }
+}
+
+void PieMenu::setButtonBadge(uint8_t index, const QString& text) {
+    auto& slot = live_data[index];
+    const auto length = static_cast<uint8_t>(qMin<int>(text.size(), BADGE_CAPACITY));
+
+    // seqlock: an odd sequence marks the write in progress, other writers wait for it to become even
+    auto sequence = slot.badge_sequence.load(std::memory_order_relaxed);
+    do {
+        sequence &= ~1u;
+    } while (!slot.badge_sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (uint8_t i = 0; i < length; i++) {
+        slot.badge_chars[i].store(text.at(i).unicode(), std::memory_order_relaxed);
+    }
+    slot.badge_length.store(length, std::memory_order_relaxed);
+
+    slot.badge_sequence.store(sequence + 2, std::memory_order_release);
+    markLiveDataChanged(index);
+}
+
+void PieMenu::setButtonProgress(uint8_t index, qreal fraction) {
+    live_data[index].progress.store(fraction < 0 ? -1.0f : qMin<float>(fraction, 1.0f), std::memory_order_release);
+    markLiveDataChanged(index);
+}
+
+void PieMenu::setLiveUpdateRate(uint32_t rate) {
+    live_update_interval = 1000 / qMax<uint32_t>(rate, 1);
+}
+
+void PieMenu::markLiveDataChanged(uint8_t index) {
+    live_data[index].changed.store(true, std::memory_order_release);
+
+    // only the first change after a flush posts an event to the GUI thread
+    if (!live_flush_pending.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, [this]() { flushLiveData(); }, Qt::QueuedConnection);
+    }
+}
+
+void PieMenu::flushLiveData() {
+    if (live_flush_clock.isValid() && live_flush_clock.elapsed() < live_update_interval) {
+        live_flush_timer.start(live_update_interval - live_flush_clock.elapsed());
+        return;
+    }
+    live_flush_clock.start();
+
+    // changes after this point schedule the next flush
+    live_flush_pending.store(false, std::memory_order_release);
+
+    QRegion region;
+    for (uint8_t i = 0; i < button_count; i++) {
+        auto& slot = live_data[i];
+
+        if (!slot.changed.exchange(false, std::memory_order_acq_rel)) {
+            continue;
+        }
+
+        const auto sequence = slot.badge_sequence.load(std::memory_order_acquire);
+
+        if (sequence != slot.shown_badge_sequence && !(sequence & 1)) {
+            QChar chars[BADGE_CAPACITY];
+            const auto length = qMin(slot.badge_length.load(std::memory_order_relaxed), BADGE_CAPACITY);
+
+            for (uint8_t c = 0; c < length; c++) {
+                chars[c] = QChar(slot.badge_chars[c].load(std::memory_order_relaxed));
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // a torn read is dropped, the interfering writer marks the slot changed again
+            if (slot.badge_sequence.load(std::memory_order_relaxed) == sequence) {
+                slot.shown_badge_sequence = sequence;
+                slot.badge = QString(chars, length);
+
+                slot.badge_text.setText(slot.badge);
+                slot.badge_text.prepare(QTransform(), font());
+                badges_relaid = true;
+
+                // both the old and the new badge area need a repaint, a shrinking badge leaves stale pixels otherwise
+                region += slot.badge_rect.toAlignedRect().adjusted(-1, -1, 1, 1);
+                initBadgeRect(i);
+                region += slot.badge_rect.toAlignedRect().adjusted(-1, -1, 1, 1);
+            }
+        }
+        const auto progress = slot.progress.load(std::memory_order_acquire);
+
+        if (progress != slot.shown_progress) {
+            slot.shown_progress = progress;
+            initProgressPath(i);
+        }
+
+        region += pie_button_paths[i].boundingRect().toAlignedRect().adjusted(-stroke_width, -stroke_width, stroke_width, stroke_width);
+    }
+
+    if (!region.isEmpty()) {
+        update(region);
+    }
+}
+
+void PieMenu::initBadgeRect(uint8_t index) {
+    auto& slot = live_data[index];
+
+    if (slot.badge.isEmpty()) {
+        slot.badge_rect = QRectF();
+        return;
+    }
+
+    const auto& ring = ring_layouts[button_rings[index]];
+    const auto center = buttonCenterPoint(index, ring.outer_radius - (ring.outer_radius - ring.inner_radius) / 4);
+    const auto text_size = slot.badge_text.size();
+
+    slot.badge_rect = QRectF(center.x() - text_size.width() / 2.0f - 4, center.y() - text_size.height() / 2.0f,
+                             text_size.width() + 8, text_size.height());
+}
+
+void PieMenu::initProgressPath(uint8_t index) {
+    auto& slot = live_data[index];
+    slot.progress_path = QPainterPath();
+
+    if (slot.shown_progress < 0) {
+        return;
+    }
+
+    const auto& ring = ring_layouts[button_rings[index]];
+    const qreal rim_radius = ring.outer_radius - 3;
+    const QRectF rim(full_size.width() / 2.0f - rim_radius, full_size.height() / 2.0f - rim_radius, rim_radius * 2, rim_radius * 2);
+
+    // Qt arcs run counterclockwise from 3 o'clock
+    const qreal start = buttonCenterAngle(index) - ring.angle_per_button / 2;
+
+    slot.progress_path.arcMoveTo(rim, -start);
+    slot.progress_path.arcTo(rim, -start, -ring.angle_per_button * slot.shown_progress);
+}
+
+QPointF PieMenu::buttonCenterPoint(uint8_t index, qreal radius) const {
+    const qreal angle = qDegreesToRadians(buttonCenterAngle(index));
+
+    return QPointF(full_size.width() / 2.0f + radius * qCos(angle), full_size.height() / 2.0f + radius * qSin(angle));
+}
+
+void PieMenu::setButtonBusy(uint8_t index, bool busy) {
+    if (index < buttons_busy.size()) {
+        buttons_busy[index] = busy;
+        update();
+    }
+}
+
+void PieMenu::dispatchButtonClick(uint8_t index) {
+    if (dispatch_mode == DIRECT_DISPATCH) {
+        emit buttonClicked(index);
+
+        if (button_actions[index]) {
+            button_actions[index]();
+        }
+
+        // //////////////////////////////////////////////////////////////////////
+        // Edit this part to not close the menu when clicking on specific buttons
+        // //////////////////////////////////////////////////////////////////////
+        hideIfNotPinned();
+        return;
+    }
+
+    if (buttons_busy[index]) {
+        // the previous click on this button is still being processed
+        return;
+    }
+
+    setButtonBusy(index, true);
+    hideIfNotPinned();
+
+    // a queued metacall would overtake the update request, and the busy overlay would never be painted
+    QCoreApplication::postEvent(this, new ButtonClickEvent(index, button_frames), Qt::LowEventPriority - 1);
+}
+
+void PieMenu::runButtonClick(uint8_t index) {
+    emit buttonClicked(index);
+
+    if (index >= button_actions.size() || !button_actions[index]) {
+        setButtonBusy(index, false);
+        emit buttonActionFinished(index);
+        return;
+    }
+
+    if (dispatch_mode != THREAD_POOL_DISPATCH) {
+        button_actions[index]();
+        setButtonBusy(index, false);
+        emit buttonActionFinished(index);
+        return;
+    }
+
+    auto watcher = new QFutureWatcher<void>(this);
+
+    QObject::connect(watcher, &QFutureWatcher<void>::finished, this, [this, watcher, index]() {
+        setButtonBusy(index, false);
+        emit buttonActionFinished(index);
+        watcher->deleteLater();
+    });
+
+    watcher->setFuture(QtConcurrent::run(button_actions[index]));
+}
+
 void PieMenu::setButtonIcon(uint8_t index, const QString& path) {
     default_button_icons[index] = QIcon(path);
 
@@ -161,58 +736,266 @@ void PieMenu::setButtonIcon(uint8_t index, const QString& path) {
     painter.drawImage(0, 0, QImage(path));
 
     disabled_button_icons[index] = QIcon(QPixmap::fromImage(img));
+
+    button_pixmaps[index] = default_button_icons[index].pixmap(pie_icon_size, pie_icon_size);
+    disabled_button_pixmaps[index] = disabled_button_icons[index].pixmap(pie_icon_size, pie_icon_size);
+    hot_path_warm = false;
+
+    initLabelPosition(index);
+}
+
+void PieMenu::setButtonText(uint8_t index, const QString& text) {
+    if (index >= button_texts.size()) {
+        throw std::invalid_argument("Could not set pie menu button text");
+    }
+
+    if (button_texts[index] != text) {
+        // only the changed label is laid out again, the others keep their cached layout
+        button_texts[index] = text;
+        initLabel(index, QFontMetricsF(font()));
+        initLabelPosition(index);
+        hot_path_warm = false;
+    }
 }
 
 void PieMenu::setCloseButtonIcon(const QIcon& icon) {
     close_icon = icon;
+    close_pixmap = close_icon.pixmap(close_icon_size, close_icon_size);
+    hot_path_warm = false;
 }
 
 void PieMenu::setPinButtonIcon(const QIcon& icon) {
     pin_icon = icon;
+    pin_pixmap = pin_icon.pixmap(pin_icon_size, pin_icon_size);
+    hot_path_warm = false;
+}
+
+void PieMenu::setTraceRecording(bool enable) {
+    if (enable && !trace_recording) {
+        recorded_trace.clear();
+        recorded_trace.setInitialConfiguration(traceConfiguration());
+        trace_clock.start();
+    }
+    trace_recording = enable;
+}
+
+PieMenuTrace::Configuration PieMenu::traceConfiguration() const {
+    PieMenuTrace::Configuration configuration;
+
+    configuration.pie_radius = pie_radius;
+    configuration.stroke_width = stroke_width;
+    configuration.base_angle = qRound(base_angle);
+    configuration.rings.clear();
+
+    for (const auto& ring : rings) {
+        configuration.rings.push_back({ring.count, ring.angle_offset});
+    }
+
+    configuration.close_button_radius = close_button_radius;
+    configuration.pin_button_radius = pin_button_radius;
+    configuration.pie_icon_size = pie_icon_size;
+    configuration.close_icon_size = close_icon_size;
+    configuration.pin_icon_size = pin_icon_size;
+    configuration.show_pin_button = show_pin_button;
+    configuration.pinned = isPinned;
+    configuration.close_as_regular_button = isCloseAsRegularButton;
+    configuration.alternate_colors = alternate_colors;
+    configuration.dispatch_mode = dispatch_mode;
+    configuration.buttons_enabled.assign(buttons_enabled.begin(), buttons_enabled.end());
+
+    return configuration;
+}
+
+void PieMenu::applyTraceConfiguration(const PieMenuTrace::Configuration& configuration) {
+    // the setters would record every single field, the result is recorded once at the end
+    const bool recording = trace_recording;
+    trace_recording = false;
+
+    std::vector<Ring> new_rings;
+    for (const auto& ring : configuration.rings) {
+        new_rings.push_back(Ring{ring.count, ring.angle_offset});
+    }
+
+    setRings(new_rings);
+    setBaseAngle(configuration.base_angle);
+    setStrokeWidth(configuration.stroke_width);
+    setCloseButtonRadius(configuration.close_button_radius);
+    setPinButtonRadius(configuration.pin_button_radius);
+    setPieButtonIconSize(configuration.pie_icon_size);
+    setCloseButtonIconSize(configuration.close_icon_size);
+    setPinButtonIconSize(configuration.pin_icon_size);
+    setShowPinButton(configuration.show_pin_button);
+    setPinned(configuration.pinned);
+    setCloseButtonAsRegularButton(configuration.close_as_regular_button);
+    setAlternateColors(configuration.alternate_colors);
+    setDispatchMode(static_cast<DispatchMode>(qMin<quint8>(configuration.dispatch_mode, THREAD_POOL_DISPATCH)));
+
+    for (uint8_t i = 0; i < qMin<size_t>(configuration.buttons_enabled.size(), button_count); i++) {
+        setButtonEnabled(i, configuration.buttons_enabled[i]);
+    }
+
+    // the pie radius goes last, it is the only setter that also repaints
+    setPieRadius(configuration.pie_radius);
+
+    trace_recording = recording;
+    recordTraceConfiguration();
+}
+
+void PieMenu::recordTraceConfiguration() {
+    if (!trace_recording) {
+        return;
+    }
+
+    recorded_trace.appendConfiguration(trace_clock.nsecsElapsed() / 1000, traceConfiguration());
+}
+
+void PieMenu::recordTraceEvent(PieMenuTrace::EventType type, const QPoint& position,
+                               Qt::MouseButton button, Qt::MouseButtons buttons) {
+    if (!trace_recording) {
+        return;
+    }
+
+    recorded_trace.append({trace_clock.nsecsElapsed() / 1000, type,
+                           static_cast<qint16>(position.x()), static_cast<qint16>(position.y()),
+                           static_cast<quint8>(button), static_cast<quint8>(buttons)});
 }
 
 void PieMenu::paintEvent(QPaintEvent *event) {
     Q_UNUSED(event);
 
+    stats.paints++;
+
+    QElapsedTimer frame_timer;
+    frame_timer.start();
+
     QPainter painter(this);
     painter.setBackgroundMode(Qt::TransparentMode);
+    painter.setRenderHint(QPainter::Antialiasing, current_quality != MINIMAL_QUALITY);
+    painter.setRenderHint(QPainter::TextAntialiasing, current_quality != MINIMAL_QUALITY);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, current_quality == FULL_QUALITY);
 
-    const auto button_under_mouse = getButtonUnderMouse();
+    if (geometry_settling) {
+        paintGeometrySnapshot(painter);
+        return;
+    }
 
-    paintPieButtons(painter, button_under_mouse);
+    {
+        // everything from the hit-test on only uses cached brushes, pens, pixmaps, paths and labels,
+        // the QPainter set up above allocates its engine state and is deliberately not counted
+        AllocationCounter counter;
 
-    paintCloseButton(painter, (button_under_mouse == close_button_index));
+        const auto button_under_mouse = getButtonUnderMouse();
+        hovered_button = button_under_mouse;
 
-    if (show_pin_button) {
-        paintPinButton(painter, (button_under_mouse == pin_button_index));
+        paintPieButtons(painter, button_under_mouse);
+        button_frames++;
+
+        paintLabels(painter);
+
+        paintLiveData(painter);
+
+        paintCloseButton(painter, (button_under_mouse == close_button_index));
+
+        if (show_pin_button) {
+            paintPinButton(painter, (button_under_mouse == pin_button_index));
+        }
+
+        if (hot_path_warm && !badges_relaid) {
+            stats.hot_path_allocations += counter.allocations();
+            Q_ASSERT_X(counter.allocations() == 0, "PieMenu::paintEvent", "painting with warm caches must not allocate");
+        }
+    }
+
+    // the first frame after a cache rebuild pays for the rebuild and says nothing about the quality tier
+    const bool measured = hot_path_warm;
+    hot_path_warm = true;
+    badges_relaid = false;
+
+    if (adaptive_quality && measured) {
+        adaptRenderQuality(frame_timer.nsecsElapsed() / 1000);
+    }
+}
+
+void PieMenu::setRenderQuality(RenderQuality quality) {
+    best_quality = quality;
+    current_quality = quality;
+    cheap_frames = 0;
+    slow_frames = 0;
+    initBrushes();
+    update();
+}
+
+void PieMenu::adaptRenderQuality(qint64 frame_time_us) {
+    const qint64 budget_us = frame_budget * 1000;
+
+    if (frame_time_us > budget_us) {
+        cheap_frames = 0;
+
+        // a single hiccup, e.g. a page fault or a preempted thread, does not lower the quality
+        if (++slow_frames >= 3 && current_quality < MINIMAL_QUALITY) {
+            slow_frames = 0;
+            current_quality = static_cast<RenderQuality>(current_quality + 1);
+            initBrushes();
+            update();
+        }
     }
+    else if (frame_time_us < budget_us / 4 && current_quality > best_quality) {
+        slow_frames = 0;
+
+        // only step up after a series of cheap frames to avoid flickering between tiers
+        if (++cheap_frames >= 30) {
+            cheap_frames = 0;
+            current_quality = static_cast<RenderQuality>(current_quality - 1);
+            initBrushes();
+            update();
+        }
+    }
+    else {
+        cheap_frames = 0;
+        slow_frames = 0;
+    }
+}
+
+const QBrush& PieMenu::getBrush(RenderFlag mode) const {
+    return brushes[qCountTrailingZeroBits(static_cast<uint32_t>(mode))];
 }
+
 // TBD
-QBrush PieMenu::getBrush(RenderFlag mode) {
+QBrush PieMenu::createBrush(RenderFlag mode) const {
 
     //QPushButton q(this);
     //(0.3f, -0.4f, 01.35f, 0.3f, -0.4f);
-    QRadialGradient gradient(QPointF(pie_radius, pie_radius), pie_radius*2);
-
     // qDebug()<< "getBrush" << mode;
-    gradient.setColorAt(1, QColor(190, 190, 190));
+    QColor color;
     switch (mode) {
     case NORMAL:
     case EVEN:
-        gradient.setColorAt(0.5, QColor(190, 190, 190));
+        color = QColor(190, 190, 190);
         break;
     case ODD:
-        gradient.setColorAt(0.5, QColor(170, 170, 170));
+        color = QColor(170, 170, 170);
         break;
     case DISABLED:
-        gradient.setColorAt(0.5, QColor(170, 170, 170));
+        color = QColor(170, 170, 170);
         break;
     case STROKE:
         return QBrush(QColor(130, 130, 130));
         break;
+    case BUSY:
+        return QBrush(QColor(60, 60, 60, 90), Qt::BDiagPattern);
+        break;
     default:
-        gradient.setColorAt(0.5, QColor(200, 200, 200));
+        color = QColor(200, 200, 200);
     }
+
+    if (current_quality != FULL_QUALITY) {
+        // flat fills are far cheaper than gradients on software rasterizers
+        return QBrush(color);
+    }
+
+    QRadialGradient gradient(QPointF(pie_radius, pie_radius), pie_radius*2);
+    gradient.setColorAt(1, QColor(190, 190, 190));
+    gradient.setColorAt(0.5, color);
     gradient.setColorAt(0, QColor(250,250,250));
     return gradient;
 }
@@ -227,117 +1010,200 @@ void PieMenu::paintPieButtons(QPainter& painter, int8_t mouseover) {
     }
 
     for (int8_t i = 0; i < button_count; i++) {
+        if (buttons_busy[i]) {
+            painter.fillPath(pie_button_paths[i], getBrush(BUSY));
+        }
+    }
+
+    for (uint8_t i = 0; i < button_count; i++) {
         applyStroke(painter, pie_button_paths[i]);
+    }
 
-        qreal angle = angle_per_button * i + base_angle - angle_per_button * 0.5f;
+    for (uint8_t i = 0; i < button_count; i++) {
+        const auto center = buttonCenterPoint(i, ring_layouts[button_rings[i]].icon_radius);
 
-        QPoint reference_point = QPoint(((pie_radius + (close_button_radius + stroke_width / 2) / 2  - pie_icon_size / 2)) * qCos((angle * M_PI) / 180) + pie_radius,
-                                        ((pie_radius + (close_button_radius + stroke_width / 2) / 2  - pie_icon_size / 2)) * qSin((angle * M_PI) / 180) + pie_radius);
+        painter.drawPixmap(QRectF(center.x() - pie_icon_size / 2.0f, center.y() - pie_icon_size / 2.0f, pie_icon_size, pie_icon_size).toRect(),
+                           buttons_enabled[i] ? button_pixmaps[i] : disabled_button_pixmaps[i]);
+    }
+}
 
-        int8_t index = i + 1;
+void PieMenu::paintLiveData(QPainter& painter) {
+    for (uint8_t i = 0; i < button_count; i++) {
+        const auto& slot = live_data[i];
 
-        if (index >= button_count) {
-            index = 0;
+        if (slot.shown_progress >= 0) {
+            // the arc is prebuilt, drawArc() would build a temporary path on every paint
+            painter.strokePath(slot.progress_path, progress_pen);
         }
 
-        painter.drawPixmap(QRect((reference_point.x() * 2 + full_size.width() / 2) / 3 - pie_icon_size / 2 + stroke_width, (reference_point.y() * 2 + full_size.height() / 2) / 3 - pie_icon_size / 2 + stroke_width, pie_icon_size, pie_icon_size),
-                           buttons_enabled[index] ? default_button_icons[index].pixmap(pie_icon_size, pie_icon_size) : disabled_button_icons[index].pixmap(pie_icon_size, pie_icon_size));
+        if (!slot.badge.isEmpty()) {
+            const auto& badge_rect = slot.badge_rect;
+
+            painter.setPen(Qt::NoPen);
+            painter.setBrush(badge_brush);
+            painter.drawRoundedRect(badge_rect, badge_rect.height() / 2, badge_rect.height() / 2);
+            painter.setPen(badge_text_pen);
+            painter.drawStaticText(badge_rect.topLeft() + QPointF(4, 0), slot.badge_text);
+        }
+    }
+}
+
+void PieMenu::paintLabels(QPainter& painter) {
+    for (uint8_t i = 0; i < button_count; i++) {
+        if (!button_texts[i].isEmpty()) {
+            painter.setPen(buttons_enabled[i] ? label_pen : disabled_label_pen);
+            painter.drawStaticText(button_label_positions[i], button_labels[i]);
+        }
     }
 }
 
 void  PieMenu::applyStroke(QPainter& painter, QPainterPath & path) {
-    painter.setPen(QPen(getBrush(STROKE), stroke_width));
+    painter.setPen(stroke_pen);
     painter.drawPath(path);
 }
 
 
 void PieMenu::paintCloseButton(QPainter& painter, bool mouseover) {
+    painter.setPen(stroke_pen);
     painter.setBrush(getBrush(mouseover? ACTIVE: NORMAL));
 
     painter.drawEllipse(QRectF(pie_radius - close_button_radius + stroke_width, pie_radius - close_button_radius + stroke_width,
                                close_button_radius * 2, close_button_radius * 2));
 
     painter.drawPixmap(QRect(full_size.width() / 2 - close_icon_size / 2, full_size.height() / 2 - close_icon_size / 2,
-                             close_icon_size, close_icon_size), close_icon.pixmap(close_icon_size, close_icon_size));
+                             close_icon_size, close_icon_size), close_pixmap);
 }
 
 void PieMenu::paintPinButton(QPainter& painter, bool mouseover) {
+    painter.setPen(stroke_pen);
     painter.setBrush(getBrush(mouseover? ACTIVE: NORMAL));
     painter.drawEllipse(QRectF(base_size.width() - pin_button_radius * 2, stroke_width, pin_button_radius * 2, pin_button_radius * 2));
     painter.drawPixmap(QRect(base_size.width() - pin_button_radius - pin_icon_size / 2, stroke_width + pin_button_radius - pin_icon_size / 2,
-                             pin_icon_size, pin_icon_size), pin_icon.pixmap(pin_icon_size, pin_icon_size));
+                             pin_icon_size, pin_icon_size), pin_pixmap);
 }
 
 int8_t PieMenu::getButtonUnderMouse() const {
-    const auto cursor = mapFromGlobal(QCursor::pos());
+    // the velocity only changes on pointer events, a resting pointer must not be extrapolated
+    if (prediction_horizon == 0 || !pointer_clock.isValid() || pointer_clock.elapsed() >= POINTER_REST_MS) {
+        return getButtonAt(pointer_position);
+    }
+    return getButtonAt(pointer_position + (pointer_velocity * prediction_horizon).toPoint());
+}
+
+int8_t PieMenu::getButtonAt(const QPoint& cursor) const {
+    stats.hit_tests++;
 
     if (cursor.x() <= 0 || cursor.x() >= full_size.width() || cursor.y() < 0 || cursor.y() >= full_size.height()) {
         // out of widget
         return -1;
     }
 
-    int8_t nearest = -1;
-    uint32_t distance = UINT_MAX;
-    for (int i = 0; i < button_count; i++) {
-        qreal angle = angle_per_button * i + base_angle - angle_per_button * 0.5f;
+    qreal distance_to_pin_button = sqrt(std::pow(base_size.width() - pin_button_radius - cursor.x(), 2) + std::pow(pin_button_radius - cursor.y(), 2));
 
-        QPoint reference_point = QPoint(pie_radius * qCos((angle * M_PI) / 180) + pie_radius,
-                                        pie_radius * qSin((angle * M_PI) / 180) + pie_radius);
+    if (distance_to_pin_button < pin_button_radius + stroke_width) {
+        return pin_button_index;
+    }
 
-        uint32_t current = sqrt(std::pow(reference_point.x() - cursor.x(), 2) + std::pow(reference_point.y() - cursor.y(), 2));
+    const qreal dx = cursor.x() - full_size.width() / 2.0f;
+    const qreal dy = cursor.y() - full_size.height() / 2.0f;
+    const qreal distance_to_center = qSqrt(dx * dx + dy * dy);
 
-        if (current < distance) {
-            distance = current;
+    if (distance_to_center < close_button_radius + stroke_width) {
+        return close_button_index;
+    }
 
-            int index = i + 1;
+    // the ring follows from the radius, points outside the pie belong to the outermost ring
+    const auto& inner_ring = ring_layouts.front();
+    const qreal thickness = inner_ring.outer_radius - inner_ring.inner_radius;
+    const auto ring_index = qBound<int>(0, qFloor((distance_to_center - close_button_radius) / thickness), int(rings.size()) - 1);
+    const auto& ring = ring_layouts[ring_index];
 
-            if (index >= button_count) {
-                index = 0;
-            }
-            nearest = index;
+    // the button follows from the angle, button j spans [(j - 2), (j - 1)) * angle_per_button + base_angle
+    const qreal angle = qRadiansToDegrees(qAtan2(dy, dx)) - ring.base_angle;
+    auto local = (qFloor(angle / ring.angle_per_button) + 2) % int(ring.count);
+
+    if (local < 0) {
+        local += ring.count;
+    }
+    return ring.first_index + local;
+}
+
+void PieMenu::activateButton(int8_t index) {
+    if (index == pin_button_index) {
+        isPinned = !isPinned;
+    }
+    else if (index == close_button_index) {
+        if (!isPinned || !isCloseAsRegularButton) {
+            hide();
+        } else if (dispatch_mode == DIRECT_DISPATCH) {
+            emit buttonClicked(index);
+        } else {
+            // the close button has no action, but its click is delivered like any other button's
+            QMetaObject::invokeMethod(this, [this, index]() { emit buttonClicked(index); }, Qt::QueuedConnection);
         }
+
+    }
+    else if (index >= 0 && index < button_count && buttons_enabled[index]) {
+        dispatchButtonClick(index);
     }
+}
 
-    qreal distance_to_pin_button = sqrt(std::pow(base_size.width() - pin_button_radius - cursor.x(), 2) + std::pow(pin_button_radius - cursor.y(), 2));
+void PieMenu::setPointerPosition(const QPoint& position) {
+    if (pointer_clock.isValid()) {
+        const auto elapsed = pointer_clock.nsecsElapsed() / 1e6;
 
-    if (distance_to_pin_button < pin_button_radius + stroke_width) {
-        return pin_button_index;
+        if (elapsed > 0 && elapsed < POINTER_REST_MS) {
+            // exponential smoothing keeps single jittery samples from dominating
+            pointer_velocity = pointer_velocity * 0.5 + QPointF(position - pointer_position) / elapsed * 0.5;
+        }
+        else {
+            pointer_velocity = QPointF();
+        }
     }
+    pointer_clock.start();
+    pointer_position = position;
 
-    qreal distance_to_close_button = sqrt(std::pow(base_size.width() / 2 - cursor.x(), 2) + std::pow(base_size.height() / 2 - cursor.y(), 2));
+    if (prediction_horizon != 0 && !pointer_velocity.isNull() && !pointer_rest_timer.isActive()) {
+        // registering the timer is event loop bookkeeping like update(), not part of the hover path
+        AllocationExclusion exclusion;
+        pointer_rest_timer.start(POINTER_REST_MS);
+    }
+}
 
-    if (distance_to_close_button < close_button_radius + stroke_width) {
-        return close_button_index;
+void PieMenu::restPointer() {
+    if (pointer_clock.isValid() && pointer_clock.elapsed() < POINTER_REST_MS) {
+        // the pointer moved meanwhile, check again once it may have stopped
+        pointer_rest_timer.start(POINTER_REST_MS - pointer_clock.elapsed());
+        return;
+    }
+
+    pointer_velocity = QPointF();
+    updateHover();
+}
+
+void PieMenu::updateHover() {
+    const auto button_under_mouse = getButtonUnderMouse();
+
+    if (button_under_mouse != hovered_button) {
+        hovered_button = button_under_mouse;
+        update();
     }
-    return nearest;
 }
 
 void PieMenu::mouseReleaseEvent(QMouseEvent *event)
 {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    const auto position = event->position().toPoint();
+#else
+    const auto position = event->pos();
+#endif
+
+    setPointerPosition(position);
+    recordTraceEvent(PieMenuTrace::MOUSE_RELEASE, position, event->button(), event->buttons());
     update();
 
     if (event->button() == Qt::LeftButton) {
-        const auto button_under_mouse = getButtonUnderMouse();
-
-        if (button_under_mouse == pin_button_index) {
-            isPinned = !isPinned;
-        }
-        else if (button_under_mouse == close_button_index) {
-            if (!isPinned || !isCloseAsRegularButton) {
-                hide();
-            } else {
-                emit buttonClicked(button_under_mouse);
-            }
-
-        }
-        else if (button_under_mouse >= 0 && button_under_mouse < button_count && buttons_enabled[button_under_mouse]) {
-            emit buttonClicked(button_under_mouse);
-
-            // //////////////////////////////////////////////////////////////////////
-            // Edit this part to not close the menu when clicking on specific buttons
-            // //////////////////////////////////////////////////////////////////////
-            hideIfNotPinned();
-        }
+        activateButton(getButtonAt(pointer_position));
         QWidget::mouseReleaseEvent(event);
     }
     else {
@@ -346,16 +1212,165 @@ void PieMenu::mouseReleaseEvent(QMouseEvent *event)
 }
 
 void PieMenu::mousePressEvent(QMouseEvent *event) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    const auto position = event->position().toPoint();
+#else
+    const auto position = event->pos();
+#endif
+
+    setPointerPosition(position);
+    recordTraceEvent(PieMenuTrace::MOUSE_PRESS, position, event->button(), event->buttons());
     update();
     QWidget::mousePressEvent(event);
 }
 
 void PieMenu::mouseMoveEvent(QMouseEvent *event) {
-    update();
+    AllocationCounter counter;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    const auto position = event->position().toPoint();
+#else
+    const auto position = event->pos();
+#endif
+
+    setPointerPosition(position);
+    {
+        // the trace grows its event buffer while recording, and update() lets Qt merge
+        // the dirty region and post an update request, neither is part of the hover path
+        AllocationExclusion exclusion;
+        recordTraceEvent(PieMenuTrace::MOUSE_MOVE, position, event->button(), event->buttons());
+        update();
+    }
     QWidget::mouseMoveEvent(event);
+
+    stats.hot_path_allocations += counter.allocations();
+    Q_ASSERT_X(counter.allocations() == 0, "PieMenu::mouseMoveEvent", "pointer tracking must not allocate");
+}
+
+void PieMenu::changeEvent(QEvent *event) {
+    if (event->type() == QEvent::FontChange) {
+        initLabelLayout();
+
+        for (uint8_t i = 0; i < button_count; i++) {
+            live_data[i].badge_text.prepare(QTransform(), font());
+            initBadgeRect(i);
+        }
+        update();
+    }
+    QWidget::changeEvent(event);
 }
 
 void PieMenu::leaveEvent(QEvent *event) {
+    pointer_position = QPoint(-1, -1);
+    pointer_velocity = QPointF();
+    pointer_clock.invalidate();
+    recordTraceEvent(PieMenuTrace::LEAVE, pointer_position);
     update();
     QWidget::leaveEvent(event);
 }
+
+void PieMenu::tabletEvent(QTabletEvent *event) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    const auto position = event->position().toPoint();
+#else
+    const auto position = event->pos();
+#endif
+
+    setPointerPosition(position);
+
+    switch (event->type()) {
+    case QEvent::TabletPress:
+        recordTraceEvent(PieMenuTrace::MOUSE_PRESS, position, Qt::LeftButton, Qt::LeftButton);
+        hovered_button = getButtonUnderMouse();
+        update();
+        break;
+    case QEvent::TabletRelease:
+        recordTraceEvent(PieMenuTrace::MOUSE_RELEASE, position, Qt::LeftButton, Qt::NoButton);
+        update();
+        activateButton(getButtonAt(pointer_position));
+        break;
+    default:
+        // pens report at several hundred Hz, only repaint when the highlight changes
+        recordTraceEvent(PieMenuTrace::MOUSE_MOVE, position, Qt::NoButton, event->buttons());
+        updateHover();
+        break;
+    }
+
+    // accepting the event suppresses the synthesized mouse event
+    event->accept();
+}
+
+void PieMenu::touchEvent(QTouchEvent *event) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    const auto& points = event->points();
+#else
+    const auto& points = event->touchPoints();
+#endif
+
+    if (event->type() == QEvent::TouchCancel || points.isEmpty()) {
+        pointer_position = QPoint(-1, -1);
+        pointer_velocity = QPointF();
+        pointer_clock.invalidate();
+        recordTraceEvent(PieMenuTrace::LEAVE, pointer_position);
+        update();
+        event->accept();
+        return;
+    }
+
+    // only the first finger selects, further fingers are ignored
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    const auto position = points.first().position().toPoint();
+#else
+    const auto position = points.first().pos().toPoint();
+#endif
+
+    setPointerPosition(position);
+
+    switch (event->type()) {
+    case QEvent::TouchBegin:
+        recordTraceEvent(PieMenuTrace::MOUSE_PRESS, position, Qt::LeftButton, Qt::LeftButton);
+        hovered_button = getButtonUnderMouse();
+        update();
+        break;
+    case QEvent::TouchEnd:
+        recordTraceEvent(PieMenuTrace::MOUSE_RELEASE, position, Qt::LeftButton, Qt::NoButton);
+        activateButton(getButtonAt(pointer_position));
+
+        // a lifted finger hovers nothing, a pinned menu must not keep highlighting the lift point
+        pointer_position = QPoint(-1, -1);
+        pointer_velocity = QPointF();
+        pointer_clock.invalidate();
+        recordTraceEvent(PieMenuTrace::LEAVE, pointer_position);
+        update();
+        break;
+    default:
+        recordTraceEvent(PieMenuTrace::MOUSE_MOVE, position, Qt::NoButton, Qt::LeftButton);
+        updateHover();
+        break;
+    }
+
+    event->accept();
+}
+
+bool PieMenu::event(QEvent *event) {
+    switch (event->type()) {
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+    case QEvent::TouchCancel:
+        touchEvent(static_cast<QTouchEvent*>(event));
+        return true;
+    default:
+        if (event->type() == ButtonClickEvent::eventType()) {
+            const auto click = static_cast<ButtonClickEvent*>(event);
+
+            // a menu that stayed open must have shown the busy overlay before the action blocks the GUI thread
+            Q_ASSERT_X(!isVisible() || button_frames != click->frame, "PieMenu::event",
+                       "the busy overlay must be painted before the button action runs");
+
+            runButtonClick(click->index);
+            return true;
+        }
+        return QWidget::event(event);
+    }
+}
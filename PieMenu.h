@@ -22,6 +22,18 @@
 #include <QtMath>
 #include <QICon>
 #include <QPainterPath>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QStaticText>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "PieMenuTrace.h"
+
+class QTouchEvent;
 
 /// \brief A simple pie menu widget for Qt
 class PieMenu : public QWidget
@@ -38,7 +50,55 @@ public:
         EVEN = 0x4,
         DISABLED = 0x8,
         STROKE = 0x10,
-        ACTIVE = 0x20
+        ACTIVE = 0x20,
+        BUSY = 0x40
+    };
+
+    /// \brief How button clicks are delivered
+    enum DispatchMode {
+        /// \brief buttonClicked is emitted before the menu hides (default)
+        DIRECT_DISPATCH,
+        /// \brief The menu hides or shows the busy button first, buttonClicked and
+        /// the button action run once that repaint has been flushed
+        QUEUED_DISPATCH,
+        /// \brief Like QUEUED_DISPATCH, but the button action runs in the global thread pool
+        THREAD_POOL_DISPATCH
+    };
+
+    /// \brief Rendering quality tiers, from most to least expensive
+    enum RenderQuality {
+        /// \brief Anti-aliased gradients and smoothly scaled icons
+        FULL_QUALITY,
+        /// \brief Anti-aliased flat fills
+        REDUCED_QUALITY,
+        /// \brief Flat fills without any anti-aliasing
+        MINIMAL_QUALITY
+    };
+
+    /// \brief A concentric ring of pie buttons
+    struct Ring {
+        /// \brief The amount of buttons in the ring
+        uint8_t count;
+        /// \brief The angle of the ring in degrees, relative to the base angle
+        qreal angle_offset = 0;
+    };
+
+    /// \brief The maximum amount of characters of a button badge
+    static constexpr uint8_t BADGE_CAPACITY = 16;
+
+    /// \brief Counters of the work done by the pie menu
+    struct Statistics {
+        /// \brief Amount of paint events handled
+        quint64 paints = 0;
+        /// \brief Amount of button hit-tests performed
+        quint64 hit_tests = 0;
+        /// \brief Heap allocations on the warmed up hover path (mouse move, hit-test, paint)
+        /// Only counted when built with PIEMENU_COUNT_ALLOCATIONS and an allocator replacement
+        /// calling countAllocation(), expected to stay zero. The demo program interposes
+        /// malloc(), calloc() and realloc() on glibc and only the global operator new elsewhere.
+        /// Excluded on purpose are the QPainter construction, update(), which posts a new
+        /// update request event, and trace recording.
+        quint64 hot_path_allocations = 0;
     };
 
     /// \brief Constructor of the PieMenu widget
@@ -52,26 +112,37 @@ public:
     /// Note: the position is mapped to the parent coordinate system
     void display();
 
+    /// \brief Displays the pie menu at the given position, e.g. a touch point
+    /// Note: the position is mapped to the parent coordinate system
+    /// \param global_position: The center of the pie menu in global coordinates
+    void display(const QPoint& global_position);
+
     /// \brief Sets the icon image of the pie button with the given index
     /// \param index: The index of the button
     /// \param path: Reference to the path of the icon file
     void setButtonIcon(uint8_t index, const QString& path);
 
+    /// \brief Sets the text label of the pie button with the given index
+    /// The label is wrapped or elided to fit the button
+    /// \param index: The index of the button
+    /// \param text: Reference to the label text, an empty text removes the label
+    void setButtonText(uint8_t index, const QString& text);
+
     /// \brief Sets the icon of the close button
     /// \param icon: Reference to the icon
     void setCloseButtonIcon(const QIcon& icon);
 
     /// \brief Sets the icon of the close button
     /// \param icon: Reference to the icon
-    void setCloseButtonAsRegularButton(bool value) {isCloseAsRegularButton = value; };
+    void setCloseButtonAsRegularButton(bool value) {isCloseAsRegularButton = value; recordTraceConfiguration(); };
 
     /// \brief Sets the show pin button visible
     /// \param value: show pin button visible flag
-    void setShowPinButton(bool value) {show_pin_button = value;};
+    void setShowPinButton(bool value) {show_pin_button = value; recordTraceConfiguration(); };
 
     /// \brief Sets pinned
     /// \param value: set
-    void setPinned(bool value) {isPinned = value;};
+    void setPinned(bool value) {isPinned = value; recordTraceConfiguration(); };
 
     /// \brief Sets the icon of the pin button
     /// \param icon: Reference to the icon
@@ -83,9 +154,19 @@ public:
     void setButtonEnabled(uint8_t index, bool enable);
 
     /// \brief Sets the amount of pie buttons and updates dependent parameters
+    /// The buttons are arranged in a single ring
     /// \param count: The new amount of pie buttons
     void setButtonCount(uint8_t count);
 
+    /// \brief Returns the total amount of pie buttons in all rings
+    uint8_t buttonCount() const { return button_count; };
+
+    /// \brief Arranges the pie buttons in concentric rings and updates dependent parameters
+    /// The rings evenly share the space between the close button and the pie radius.
+    /// Buttons are numbered ring by ring, starting with the innermost ring.
+    /// \param rings: The rings from the innermost to the outermost, at most 125 buttons in total
+    void setRings(const std::vector<Ring>& rings);
+
     /// \brief Sets the base angle of the pie buttons and updates dependent parameters
     /// \param angle: The new base angle
     void setBaseAngle(int32_t angle);
@@ -122,30 +203,270 @@ public:
     /// \param size: The new icon size in pixels
     void setPinButtonIconSize(uint8_t size);
 
+    /// \brief Sets how button clicks are delivered
+    /// \param mode: The new dispatch mode
+    void setDispatchMode(DispatchMode mode) { dispatch_mode = mode; recordTraceConfiguration(); };
+
+    /// \brief Sets an action that is run when the button with the given index is clicked
+    /// In the queued and thread pool dispatch modes, the button is marked busy until the
+    /// action has finished and further clicks on it are ignored meanwhile.
+    /// Thread pool actions must not access widgets.
+    /// \param index: The index of the button
+    /// \param action: The action to be run, or an empty function to remove it
+    void setButtonAction(uint8_t index, std::function<void()> action);
+
+    /// \brief Returns whether a click on the button with the given index is still being processed
+    /// \param index: The index of the button
+    bool isButtonBusy(uint8_t index) const { return index < buttons_busy.size() && buttons_busy[index] != 0; };
+
+    /// \brief Sets how far ahead the pointer position is predicted for highlighting
+    /// The highlighted button follows the extrapolated pointer movement,
+    /// clicks are always resolved at the actual pointer position.
+    /// Once the pointer rests, the highlight falls back to the actual pointer position.
+    /// \param milliseconds: The prediction horizon, 0 disables the prediction
+    void setPointerPrediction(uint32_t milliseconds) { prediction_horizon = milliseconds; };
+
+    /// \brief Sets the best rendering quality and switches to it
+    /// \param quality: The new rendering quality
+    void setRenderQuality(RenderQuality quality);
+
+    /// \brief Returns the rendering quality currently in use
+    RenderQuality renderQuality() const { return current_quality; };
+
+    /// \brief Sets whether the rendering quality adapts to the measured paint time
+    /// A few consecutive frames exceeding the frame budget lower the quality by one tier, a series
+    /// of frames far below the budget raises it up to the quality set by setRenderQuality().
+    /// Frames that rebuild the paint caches are not taken into account.
+    /// \param value: Whether the rendering quality should adapt
+    void setAdaptiveQuality(bool value) { adaptive_quality = value; };
+
+    /// \brief Sets the paint time above which the rendering quality is lowered
+    /// \param milliseconds: The new frame budget
+    void setFrameBudget(uint32_t milliseconds) { frame_budget = milliseconds; };
+
+    /// \brief Sets whether pie radius, stroke width and base angle changes are rendered progressively
+    /// While these values change continuously, a scaled and rotated copy of the last full
+    /// render is shown. The full rebuild happens once no change occurred for the settle time.
+    /// \param value: Whether geometry changes should be rendered progressively
+    void setProgressiveGeometry(bool value) { progressive_geometry = value; };
+
+    /// \brief Sets the time without geometry changes after which the full rebuild happens
+    /// \param milliseconds: The new settle time
+    void setGeometrySettleTime(uint32_t milliseconds) { settle_time = milliseconds; };
+
+    /// \brief Sets the badge text shown on the button with the given index
+    /// Thread-safe, may be called from any thread at any rate, the text is copied into a fixed buffer.
+    /// The GUI thread never waits for a writer, concurrent writers to the same
+    /// button wait for each other. Only the first change after a flush posts an event
+    /// to the GUI thread. Changes are merged into one repaint per live update interval.
+    /// \param index: The index of the button
+    /// \param text: The badge text, an empty text hides the badge, only the first
+    /// BADGE_CAPACITY characters are shown
+    void setButtonBadge(uint8_t index, const QString& text);
+
+    /// \brief Sets the progress shown on the rim of the button with the given index
+    /// Thread-safe, may be called from any thread at any rate. Only the first change
+    /// after a flush posts an event to the GUI thread, all others are plain atomic stores.
+    /// Changes are merged into one repaint per live update interval.
+    /// \param index: The index of the button
+    /// \param fraction: The progress from 0 to 1, a negative value hides the progress
+    void setButtonProgress(uint8_t index, qreal fraction);
+
+    /// \brief Sets the maximum rate at which badge and progress changes are repainted
+    /// \param rate: The maximum amount of repaints per second
+    void setLiveUpdateRate(uint32_t rate);
+
+    /// \brief Starts or stops recording the received mouse and hover events
+    /// Starting a recording discards the previously recorded trace. Configuration
+    /// changes made through the setters are recorded as well.
+    /// \param enable: Whether events should be recorded
+    void setTraceRecording(bool enable);
+
+    /// \brief Returns whether mouse and hover events are being recorded
+    bool isTraceRecording() const { return trace_recording; };
+
+    /// \brief Returns the trace of the current or last recording
+    const PieMenuTrace& trace() const { return recorded_trace; };
+
+    /// \brief Returns the current configuration in the form stored in traces
+    PieMenuTrace::Configuration traceConfiguration() const;
+
+    /// \brief Applies a configuration stored in a trace, e.g. before replaying it
+    /// \param configuration: Reference to the configuration
+    void applyTraceConfiguration(const PieMenuTrace::Configuration& configuration);
+
+    /// \brief Returns the paint and hit-test counters
+    const Statistics& statistics() const { return stats; };
+
+    /// \brief Resets the paint and hit-test counters to zero
+    void resetStatistics() { stats = Statistics(); };
+
+#ifdef PIEMENU_COUNT_ALLOCATIONS
+    /// \brief Counts a heap allocation if the current thread is on the measured hover path
+    /// Called by the allocator replacement of the program, the widget itself replaces nothing
+    static void countAllocation() noexcept;
+#endif
+
 signals:
     /// \brief Emitted when one of the pie menu buttons is clicked
     /// \param index: The index of the clicked button
     void buttonClicked(uint8_t index);
 
+    /// \brief Emitted when a dispatched click on a button has been fully processed
+    /// Only emitted in the queued and thread pool dispatch modes
+    /// \param index: The index of the button
+    void buttonActionFinished(uint8_t index);
+
 protected:
     /// \brief Creates QPainterPath objects for the pie button shapes
     void initPainterPaths();
 
+    /// \brief Creates the brushes and pens for the current radius, stroke width and quality
+    void initBrushes();
+
+    /// \brief Renders the icons into pixmaps of the configured icon sizes
+    void initPixmaps();
+
+    /// \brief Calculates the angles and radii of the button rings
+    void initRingLayout();
+
+    /// \brief Prepares a progressively rendered geometry change
+    /// Must be called before the geometry values change, so that the
+    /// snapshot still shows the last fully rendered geometry
+    /// \return Whether the change is deferred until the geometry settles
+    bool beginGeometryChange();
+
+    /// \brief Updates the hit-test geometry and repaints after a deferred geometry change
+    void updateDeferredGeometry();
+
+    /// \brief Rebuilds everything once the geometry has settled
+    void finishGeometryChange();
+
+    /// \brief Paints the transformed snapshot and the live pin button while the geometry is changing
+    /// \param painter: Reference to the QPainter
+    void paintGeometrySnapshot(QPainter& painter);
+
+    /// \brief Calculates the angle of the center line of a pie button
+    /// \param index: The index of the button
+    /// \return The angle in degrees, clockwise from 3 o'clock
+    qreal buttonCenterAngle(uint8_t index) const;
+
+    /// \brief Fits the button texts to the button geometry and caches the result
+    /// Needed when the font, the radii, the stroke width, the icon size or the button count change,
+    /// the single ring icon radius depends on all of them
+    void initLabelLayout();
+
+    /// \brief Fits the text of a single button to its geometry and caches the result
+    /// \param index: The index of the button
+    /// \param metrics: The metrics of the current font
+    void initLabel(uint8_t index, const QFontMetricsF& metrics);
+
+    /// \brief Calculates the positions of the cached button labels
+    /// Needed when the label layout, the base angle, the stroke width or an icon change
+    void initLabelPositions();
+
+    /// \brief Calculates the position of the cached label of a single button
+    /// \param index: The index of the button
+    void initLabelPosition(uint8_t index);
+
     /// \brief Calculates the index of the button that the mouse is over
+    /// The mouse position is the one of the last received pointer event,
+    /// extrapolated if pointer prediction is enabled
+    /// \return The button index or -1, if not on a button
+    int8_t getButtonUnderMouse(void) const;
+
+    /// \brief Calculates the index of the button at the given position
     /// The buttons are numbered from 0 to n, index n+1 is the close button
     /// and index n+2 is the pin/unpin button
+    /// \param cursor: The cursor position in widget coordinates
     /// \return The button index or -1, if not on a button
-    int8_t getButtonUnderMouse(void) const;
+    int8_t getButtonAt(const QPoint& cursor) const;
+
+    /// \brief Stores a new pointer position and updates the pointer velocity
+    /// \param position: The pointer position in widget coordinates
+    void setPointerPosition(const QPoint& position);
+
+    /// \brief Repaints only if the highlighted button has changed
+    /// Used to compress high frequency touch and tablet movement
+    void updateHover();
+
+    /// \brief Stops the pointer prediction once the pointer has rested for POINTER_REST_MS
+    void restPointer();
+
+    /// \brief Triggers the function of a button, as on a left click
+    /// \param index: The index of the button, or -1 for none
+    void activateButton(int8_t index);
+
+    /// \brief Delivers a click on a pie button according to the dispatch mode
+    /// \param index: The index of the clicked button
+    void dispatchButtonClick(uint8_t index);
+
+    /// \brief Emits a queued button click and runs the button action
+    /// Only used in the queued and thread pool dispatch modes
+    /// \param index: The index of the clicked button
+    void runButtonClick(uint8_t index);
+
+    /// \brief Marks the live data of a button as changed and schedules a flush
+    /// Called from arbitrary threads
+    /// \param index: The index of the button
+    void markLiveDataChanged(uint8_t index);
+
+    /// \brief Takes over the changed live data and repaints the affected buttons
+    /// Runs on the GUI thread at most once per live update interval
+    void flushLiveData();
+
+    /// \brief Builds the rim arc for the displayed progress of a pie button
+    /// \param index: The index of the button
+    void initProgressPath(uint8_t index);
+
+    /// \brief Calculates the area of the displayed badge of a pie button
+    /// Badges sit near the rim and may reach beyond their button
+    /// \param index: The index of the button
+    void initBadgeRect(uint8_t index);
+
+    /// \brief Paints the badges and progress rims of the pie buttons
+    /// \param painter: Reference to the QPainter
+    void paintLiveData(QPainter& painter);
+
+    /// \brief Calculates a point on the center line of a pie button
+    /// \param index: The index of the button
+    /// \param radius: The distance of the point from the pie center
+    /// \return The point in widget coordinates
+    QPointF buttonCenterPoint(uint8_t index, qreal radius) const;
+
+    /// \brief Sets the busy state of a pie button and schedules a repaint
+    /// \param index: The index of the button
+    /// \param busy: The new busy state
+    void setButtonBusy(uint8_t index, bool busy);
+
+    /// \brief Appends an event to the recorded trace if recording is active
+    /// \param type: The type of the event
+    /// \param position: The position of the event in widget coordinates
+    /// \param button: The button that caused the event
+    /// \param buttons: The button state during the event
+    void recordTraceEvent(PieMenuTrace::EventType type, const QPoint& position,
+                          Qt::MouseButton button = Qt::NoButton, Qt::MouseButtons buttons = Qt::NoButton);
+
+    /// \brief Appends the current configuration to the recorded trace if recording is active
+    void recordTraceConfiguration();
 
     /// \brief Event handler to paint the widget
     /// \param event: Pointer to the paint event
     void paintEvent(QPaintEvent *event) override;
 
+    /// \brief Lowers or raises the rendering quality based on the last paint time
+    /// \param frame_time_us: The duration of the last paint event in microseconds
+    void adaptRenderQuality(qint64 frame_time_us);
+
     /// \brief Paints the custom-shaped pie menu buttons
     /// \param painter: Reference to the QPainter
     /// \param mouseover: The index of the button that the mouse is over
     void paintPieButtons(QPainter& painter, int8_t mouseover);
 
+    /// \brief Paints the cached text labels of the pie buttons
+    /// \param painter: Reference to the QPainter
+    void paintLabels(QPainter& painter);
+
     /// \brief Paints the close button in the center of the pie menu
     /// \param painter: Reference to the QPainter
     /// \param mouseover: Whether the mouse is over the button or not
@@ -172,6 +493,23 @@ protected:
     /// \param event: Pointer to the mouse event
     void leaveEvent(QEvent *event) override;
 
+    /// \brief Event handler for pen tablet input
+    /// \param event: Pointer to the tablet event
+    void tabletEvent(QTabletEvent *event) override;
+
+    /// \brief Event handler for touch input
+    /// \param event: Pointer to the touch event
+    void touchEvent(QTouchEvent *event);
+
+    /// \brief Dispatches touch events, which have no dedicated QWidget handler, and queued button clicks
+    /// \param event: Pointer to the event
+    /// \return Whether the event was recognized
+    bool event(QEvent *event) override;
+
+    /// \brief Event handler to re-layout the button labels on font changes
+    /// \param event: Pointer to the change event
+    void changeEvent(QEvent *event) override;
+
 protected:
     /// \brief The amount of pie buttons the pie menu will have
     uint8_t button_count = 4;
@@ -188,11 +526,138 @@ protected:
     /// \brief Icon for the pin/unpin icon
     QIcon pin_icon;
 
+    /// \brief Vector containing the label texts of the pie buttons
+    std::vector<QString> button_texts;
+
+    /// \brief Vector containing the laid out labels of the pie buttons
+    std::vector<QStaticText> button_labels;
+
+    /// \brief Vector containing the top left positions of the pie button labels
+    std::vector<QPointF> button_label_positions;
+
     /// \brief Vector containing the painter paths of the custom pie menu button shapes
     std::vector<QPainterPath> pie_button_paths;
 
     /// \brief Vector containing the button enable state of the pie menu buttons
-    std::vector<bool> buttons_enabled;
+    /// Not std::vector<bool>, whose bit lookups are slow in the paint loops
+    std::vector<uint8_t> buttons_enabled;
+
+    /// \brief Vector containing the busy state of the pie menu buttons
+    std::vector<uint8_t> buttons_busy;
+
+    /// \brief The amount of painted frames that showed the pie buttons and their busy state
+    quint64 button_frames = 0;
+
+    /// \brief Vector containing the pixmaps of the enabled pie buttons
+    std::vector<QPixmap> button_pixmaps;
+
+    /// \brief Vector containing the pixmaps of the disabled pie buttons
+    std::vector<QPixmap> disabled_button_pixmaps;
+
+    /// \brief Pixmap of the close icon
+    QPixmap close_pixmap;
+
+    /// \brief Pixmap of the pin/unpin icon
+    QPixmap pin_pixmap;
+
+    /// \brief Brushes for every RenderFlag, indexed by the flag's bit position
+    std::array<QBrush, 7> brushes;
+
+    /// \brief Pen for the button outlines
+    QPen stroke_pen;
+
+    /// \brief Pen for the labels of enabled buttons
+    QPen label_pen{QColor(40, 40, 40)};
+
+    /// \brief Pen for the labels of disabled buttons
+    QPen disabled_label_pen{QColor(40, 40, 40, 80)};
+
+    /// \brief Pen for the progress rims
+    QPen progress_pen{QBrush(QColor(60, 140, 220)), 4, Qt::SolidLine, Qt::FlatCap};
+
+    /// \brief Brush for the badge backgrounds
+    QBrush badge_brush{QColor(200, 50, 50)};
+
+    /// \brief Pen for the badge texts
+    QPen badge_text_pen{QColor(Qt::white)};
+
+    /// \brief Whether geometry changes are rendered progressively
+    bool progressive_geometry = false;
+
+    /// \brief Whether a progressive geometry change is waiting to settle
+    bool geometry_settling = false;
+
+    /// \brief The time without geometry changes after which the full rebuild happens
+    uint32_t settle_time = 150;
+
+    /// \brief Triggers the full rebuild once the geometry has settled
+    QTimer settle_timer;
+
+    /// \brief The last full render without the pin button before the current geometry change,
+    /// at the device pixel ratio of the widget
+    QPixmap geometry_snapshot;
+
+    /// \brief The base angle the snapshot was rendered with
+    qreal snapshot_angle = 0;
+
+    /// \brief Whether a frame has been painted since the caches were last rebuilt
+    bool hot_path_warm = false;
+
+    /// \brief Whether a badge was laid out since the last paint
+    /// Its first paint may still fill the glyph cache, but the layout itself happened
+    /// outside of the paint event, so the frame time stays valid for the quality adaptation
+    bool badges_relaid = false;
+
+    /// \brief Vector containing the actions of the pie menu buttons
+    std::vector<std::function<void()>> button_actions;
+
+    /// \brief How button clicks are delivered
+    DispatchMode dispatch_mode = DIRECT_DISPATCH;
+
+    /// \brief Badge and progress of a pie button
+    /// The atomic members are written by arbitrary threads, the others
+    /// are only accessed on the GUI thread.
+    struct LiveData {
+        /// \brief Sequence counter of the inline badge text, odd while a writer is active
+        std::atomic<uint32_t> badge_sequence{0};
+        /// \brief Length of the inline badge text
+        std::atomic<uint8_t> badge_length{0};
+        /// \brief The latest badge text, only valid when read under an even, unchanged sequence
+        std::atomic<char16_t> badge_chars[BADGE_CAPACITY] = {};
+        /// \brief The latest progress fraction
+        std::atomic<float> progress{-1.0f};
+        /// \brief Whether the slot changed since the last flush
+        std::atomic<bool> changed{false};
+
+        /// \brief The badge sequence the displayed badge was read at
+        uint32_t shown_badge_sequence = 0;
+        /// \brief The badge text being displayed
+        QString badge;
+        /// \brief The laid out badge text
+        QStaticText badge_text;
+        /// \brief The progress fraction being displayed
+        float shown_progress = -1.0f;
+        /// \brief The rim arc of the displayed progress
+        QPainterPath progress_path;
+        /// \brief The area covered by the displayed badge, empty without a badge
+        QRectF badge_rect;
+    };
+
+    /// \brief Live data for every possible button index, never reallocated
+    /// so that writers never race with setButtonCount()
+    std::unique_ptr<LiveData[]> live_data{new LiveData[UINT8_MAX + 1]};
+
+    /// \brief Whether a flush of the live data is already scheduled
+    std::atomic<bool> live_flush_pending{false};
+
+    /// \brief The minimum time between two live data flushes in milliseconds
+    uint32_t live_update_interval = 1000 / 60;
+
+    /// \brief Time of the last live data flush
+    QElapsedTimer live_flush_clock;
+
+    /// \brief Delays a live data flush until the update interval has passed
+    QTimer live_flush_timer;
 
     /// \brief Whether there should be a pin/unpin button
     bool show_pin_button = true;
@@ -215,8 +680,32 @@ protected:
     /// \brief The size of the widget including border strokes
     QSize full_size;
 
-    /// \brief The angle of each pie button in degrees
-    qreal angle_per_button;
+    /// \brief Geometry of a button ring, derived from a Ring
+    struct RingLayout {
+        /// \brief The index of the first button of the ring
+        uint8_t first_index;
+        /// \brief The amount of buttons in the ring
+        uint8_t count;
+        /// \brief The angle of each button of the ring in degrees
+        qreal angle_per_button;
+        /// \brief The absolute base angle of the ring in degrees
+        qreal base_angle;
+        /// \brief The radius where the ring starts
+        qreal inner_radius;
+        /// \brief The radius where the ring ends
+        qreal outer_radius;
+        /// \brief The distance of the button icons from the pie center
+        qreal icon_radius;
+    };
+
+    /// \brief The button rings from the innermost to the outermost
+    std::vector<Ring> rings;
+
+    /// \brief The geometry of the button rings, same order as rings
+    std::vector<RingLayout> ring_layouts;
+
+    /// \brief Vector containing the ring index of every pie button
+    std::vector<uint8_t> button_rings;
 
     /// \brief The base angle (constant offset) of the pie buttons
     qreal base_angle = 45;
@@ -244,8 +733,60 @@ protected:
 
     /// \brief The size of the pin/unpin button icon in pixels
     uint8_t pin_icon_size = 12;
+
+    /// \brief The best rendering quality, used while painting is cheap
+    RenderQuality best_quality = FULL_QUALITY;
+
+    /// \brief The rendering quality currently in use
+    RenderQuality current_quality = FULL_QUALITY;
+
+    /// \brief Whether the rendering quality adapts to the measured paint time
+    bool adaptive_quality = true;
+
+    /// \brief The paint time in milliseconds above which the quality is lowered
+    uint32_t frame_budget = 8;
+
+    /// \brief The amount of consecutive frames far below the frame budget
+    uint32_t cheap_frames = 0;
+
+    /// \brief The amount of consecutive frames above the frame budget
+    uint32_t slow_frames = 0;
+
+    /// \brief The mouse position of the last received event in widget coordinates
+    QPoint pointer_position{-1, -1};
+
+    /// \brief The estimated pointer velocity in pixels per millisecond
+    QPointF pointer_velocity;
+
+    /// \brief Time base of the pointer velocity estimation
+    QElapsedTimer pointer_clock;
+
+    /// \brief How far ahead the pointer position is predicted in milliseconds
+    uint32_t prediction_horizon = 0;
+
+    /// \brief The time without pointer events in milliseconds after which the pointer counts as stopped
+    static constexpr int64_t POINTER_REST_MS = 50;
+
+    /// \brief Ends the pointer prediction when no further pointer events arrive
+    QTimer pointer_rest_timer;
+
+    /// \brief The index of the currently highlighted button
+    int8_t hovered_button = -1;
+
+    /// \brief Whether received events are appended to the recorded trace
+    bool trace_recording = false;
+
+    /// \brief The trace of the current or last recording
+    PieMenuTrace recorded_trace;
+
+    /// \brief Time base of the current recording
+    QElapsedTimer trace_clock;
+
+    /// \brief Paint and hit-test counters, hit-tests are counted in const methods
+    mutable Statistics stats;
 private:
-    QBrush getBrush(PieMenu::RenderFlag mode);
+    const QBrush& getBrush(PieMenu::RenderFlag mode) const;
+    QBrush createBrush(PieMenu::RenderFlag mode) const;
 };
 
 #endif // PIEMENU_H
@@ -1,6 +1,6 @@
 QT       += core gui
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 
 CONFIG += c++17
 
@@ -8,14 +8,20 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# Count heap allocations on the pie menu hover path, see PieMenu::Statistics.
+# main.cpp then replaces malloc() or operator new for the whole program, so only use it for debug builds.
+#DEFINES += PIEMENU_COUNT_ALLOCATIONS
+
 SOURCES += \
     main.cpp \
     MainWindow.cpp \
-    PieMenu.cpp
+    PieMenu.cpp \
+    PieMenuTrace.cpp
 
 HEADERS += \
     MainWindow.h \
-    PieMenu.h
+    PieMenu.h \
+    PieMenuTrace.h
 
 FORMS += \
     MainWindow.ui
@@ -0,0 +1,358 @@
+/**
+ * @file PieMenuTrace.cpp
+ * @brief Recording and replay of the pointer event stream of a PieMenu
+ *
+ * A trace stores the mouse and hover events a pie menu received together
+ * with their timestamps, the menu configuration at the start of the
+ * recording and every configuration change made while recording.
+ * Traces are written in a compact binary format and can be replayed
+ * offscreen at their original or at maximum speed to obtain paint,
+ * hit-test and latency figures for a reproducible interaction.
+ */
+
+#include "PieMenuTrace.h"
+#include "PieMenu.h"
+
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QMouseEvent>
+#include <QApplication>
+
+#include <algorithm>
+
+namespace {
+    /// \brief Magic number at the start of every trace file ("PMTR")
+    constexpr quint32 TRACE_MAGIC = 0x504d5452;
+
+    /// \brief Current version of the trace file format
+    constexpr quint16 TRACE_VERSION = 1;
+
+    /// \brief Time the replay waits for the menu to paint after an event
+    constexpr qint64 PAINT_TIMEOUT_MS = 250;
+
+    enum ConfigurationFlag : quint8 {
+        SHOW_PIN_BUTTON = 0x1,
+        PINNED = 0x2,
+        CLOSE_AS_REGULAR_BUTTON = 0x4,
+        ALTERNATE_COLORS = 0x8
+    };
+
+    double percentile(std::vector<double>& values, double fraction) {
+        if (values.empty()) {
+            return 0;
+        }
+        const auto rank = static_cast<size_t>(fraction * (values.size() - 1) + 0.5);
+        std::nth_element(values.begin(), values.begin() + rank, values.end());
+        return values[rank];
+    }
+
+    void writeConfiguration(QDataStream& out, const PieMenuTrace::Configuration& configuration) {
+        out << configuration.pie_radius << configuration.stroke_width << configuration.base_angle
+            << static_cast<quint8>(configuration.rings.size());
+
+        for (const auto& ring : configuration.rings) {
+            out << ring.count << ring.angle_offset;
+        }
+
+        const quint8 flags = (configuration.show_pin_button ? SHOW_PIN_BUTTON : 0)
+                             | (configuration.pinned ? PINNED : 0)
+                             | (configuration.close_as_regular_button ? CLOSE_AS_REGULAR_BUTTON : 0)
+                             | (configuration.alternate_colors ? ALTERNATE_COLORS : 0);
+
+        out << configuration.close_button_radius << configuration.pin_button_radius
+            << configuration.pie_icon_size << configuration.close_icon_size << configuration.pin_icon_size
+            << flags << configuration.dispatch_mode
+            << static_cast<quint8>(configuration.buttons_enabled.size());
+
+        for (const auto enabled : configuration.buttons_enabled) {
+            out << enabled;
+        }
+    }
+
+    bool readConfiguration(QDataStream& in, PieMenuTrace::Configuration& configuration) {
+        quint8 ring_count = 0;
+        in >> configuration.pie_radius >> configuration.stroke_width >> configuration.base_angle >> ring_count;
+
+        configuration.rings.resize(ring_count);
+        for (auto& ring : configuration.rings) {
+            in >> ring.count >> ring.angle_offset;
+        }
+
+        quint8 flags = 0;
+        quint8 enabled_count = 0;
+
+        in >> configuration.close_button_radius >> configuration.pin_button_radius
+           >> configuration.pie_icon_size >> configuration.close_icon_size >> configuration.pin_icon_size
+           >> flags >> configuration.dispatch_mode >> enabled_count;
+
+        configuration.show_pin_button = flags & SHOW_PIN_BUTTON;
+        configuration.pinned = flags & PINNED;
+        configuration.close_as_regular_button = flags & CLOSE_AS_REGULAR_BUTTON;
+        configuration.alternate_colors = flags & ALTERNATE_COLORS;
+
+        configuration.buttons_enabled.resize(enabled_count);
+        for (auto& enabled : configuration.buttons_enabled) {
+            in >> enabled;
+        }
+
+        // reject what PieMenu::setRings() would reject
+        for (const auto& ring : configuration.rings) {
+            if (ring.count == 0) {
+                return false;
+            }
+        }
+        return in.status() == QDataStream::Ok && !configuration.rings.empty() && configuration.buttonCount() <= INT8_MAX - 2;
+    }
+
+    /// \brief Runs the event loop until the menu painted or the paint timeout expired
+    /// \return Whether the menu painted
+    bool waitForPaint(const PieMenu& menu, quint64 paints, const QElapsedTimer& since) {
+        while (menu.statistics().paints == paints) {
+            if (since.elapsed() > PAINT_TIMEOUT_MS) {
+                return false;
+            }
+            QApplication::processEvents();
+        }
+        return true;
+    }
+}
+
+PieMenuTrace::Configuration::Configuration() :
+    rings(1)
+{
+}
+
+quint32 PieMenuTrace::Configuration::buttonCount() const {
+    quint32 count = 0;
+
+    for (const auto& ring : rings) {
+        count += ring.count;
+    }
+    return count;
+}
+
+PieMenuTrace::PieMenuTrace() :
+    trace_configurations(1)
+{
+}
+
+void PieMenuTrace::clear() {
+    *this = PieMenuTrace();
+}
+
+void PieMenuTrace::appendConfiguration(qint64 timestamp_us, const Configuration& configuration) {
+    trace_configurations.push_back(configuration);
+    trace_events.push_back({timestamp_us, CONFIGURE, 0, 0, 0, 0});
+}
+
+bool PieMenuTrace::save(const QString& path) const {
+    QFile file(path);
+
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    out << TRACE_MAGIC << TRACE_VERSION << static_cast<quint32>(trace_configurations.size());
+
+    for (const auto& configuration : trace_configurations) {
+        writeConfiguration(out, configuration);
+    }
+
+    out << static_cast<quint32>(trace_events.size());
+
+    // timestamps are delta encoded, a record takes 11 bytes
+    qint64 previous = 0;
+    for (const auto& event : trace_events) {
+        out << static_cast<quint32>(qBound<qint64>(0, event.timestamp_us - previous, UINT32_MAX))
+            << static_cast<quint8>(event.type) << event.x << event.y << event.button << event.buttons;
+        previous = event.timestamp_us;
+    }
+
+    return out.status() == QDataStream::Ok;
+}
+
+bool PieMenuTrace::load(const QString& path) {
+    QFile file(path);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 count = 0;
+
+    in >> magic >> version;
+
+    if (magic != TRACE_MAGIC || version != TRACE_VERSION) {
+        return false;
+    }
+
+    clear();
+    in >> count;
+
+    if (count == 0) {
+        return false;
+    }
+
+    trace_configurations.resize(count);
+    for (auto& configuration : trace_configurations) {
+        if (!readConfiguration(in, configuration)) {
+            return false;
+        }
+    }
+
+    in >> count;
+
+    size_t configure_events = 0;
+    qint64 timestamp = 0;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        quint32 delta;
+        quint8 type;
+        Event event;
+
+        in >> delta >> type >> event.x >> event.y >> event.button >> event.buttons;
+
+        if (type < MOUSE_MOVE || type > CONFIGURE) {
+            return false;
+        }
+
+        // every CONFIGURE event needs its configuration
+        if (type == CONFIGURE && ++configure_events >= trace_configurations.size()) {
+            return false;
+        }
+
+        timestamp += delta;
+        event.timestamp_us = timestamp;
+        event.type = static_cast<EventType>(type);
+        trace_events.push_back(event);
+    }
+
+    return in.status() == QDataStream::Ok;
+}
+
+PieMenuTraceReplay::Report PieMenuTraceReplay::replay(PieMenu& menu, const PieMenuTrace& trace, Speed speed,
+                                                      const ConfigureCallback& configured, double frame_budget_ms) {
+    Report report;
+
+    auto configuration = trace.configurations().cbegin();
+    const auto applyConfiguration = [&]() {
+        menu.applyTraceConfiguration(*configuration);
+
+        if (configured) {
+            configured(menu);
+        }
+        menu.update();
+    };
+
+    applyConfiguration();
+
+    // the first paint builds the caches, it is not part of the measurement
+    QElapsedTimer warm_up;
+    warm_up.start();
+    menu.show();
+    waitForPaint(menu, menu.statistics().paints, warm_up);
+    menu.resetStatistics();
+
+    std::vector<double> latencies;
+    latencies.reserve(trace.events().size());
+
+    QElapsedTimer clock;
+    clock.start();
+
+    for (const auto& recorded : trace.events()) {
+        if (speed == ORIGINAL_SPEED) {
+            const auto wait_us = recorded.timestamp_us - clock.nsecsElapsed() / 1000;
+
+            if (wait_us > 0) {
+                QThread::usleep(static_cast<unsigned long>(wait_us));
+            }
+        }
+
+        const QPointF position(recorded.x, recorded.y);
+        const auto button = static_cast<Qt::MouseButton>(recorded.button);
+        const auto buttons = Qt::MouseButtons(QFlag(recorded.buttons));
+        const auto paints = menu.statistics().paints;
+
+        QElapsedTimer latency;
+        latency.start();
+
+        switch (recorded.type) {
+        case PieMenuTrace::MOUSE_MOVE: {
+            QMouseEvent event(QEvent::MouseMove, position, menu.mapToGlobal(position.toPoint()), button, buttons, Qt::NoModifier);
+            QApplication::sendEvent(&menu, &event);
+            break;
+        }
+        case PieMenuTrace::MOUSE_PRESS: {
+            QMouseEvent event(QEvent::MouseButtonPress, position, menu.mapToGlobal(position.toPoint()), button, buttons, Qt::NoModifier);
+            QApplication::sendEvent(&menu, &event);
+            break;
+        }
+        case PieMenuTrace::MOUSE_RELEASE: {
+            QMouseEvent event(QEvent::MouseButtonRelease, position, menu.mapToGlobal(position.toPoint()), button, buttons, Qt::NoModifier);
+            QApplication::sendEvent(&menu, &event);
+            break;
+        }
+        case PieMenuTrace::LEAVE: {
+            QEvent event(QEvent::Leave);
+            QApplication::sendEvent(&menu, &event);
+            break;
+        }
+        case PieMenuTrace::CONFIGURE:
+            // load() guarantees a configuration for every CONFIGURE event
+            ++configuration;
+            applyConfiguration();
+            report.configurations++;
+            break;
+        }
+
+        if (!menu.isVisible()) {
+            // a click closed the menu, the recorded user opened it again before the next event
+            menu.show();
+        }
+
+        if (!waitForPaint(menu, paints, latency)) {
+            report.unpainted_events++;
+            continue;
+        }
+
+        const double elapsed_ms = latency.nsecsElapsed() / 1e6;
+        latencies.push_back(elapsed_ms);
+
+        if (elapsed_ms > frame_budget_ms) {
+            report.dropped_frames += static_cast<quint64>(elapsed_ms / frame_budget_ms);
+        }
+    }
+
+    menu.hide();
+
+    report.events = trace.events().size() - report.configurations;
+    report.paints = menu.statistics().paints;
+    report.hit_tests = menu.statistics().hit_tests;
+    report.hot_path_allocations = menu.statistics().hot_path_allocations;
+    report.p50_latency_ms = percentile(latencies, 0.50);
+    report.p99_latency_ms = percentile(latencies, 0.99);
+
+    return report;
+}
+
+QString PieMenuTraceReplay::format(const Report& report) {
+    return QString("events: %0\nconfiguration changes: %1\npaints: %2\nhit-tests: %3\nhot path allocations: %4\ndropped frames: %5\nunpainted events: %6\nlatency p50: %7 ms\nlatency p99: %8 ms")
+        .arg(report.events)
+        .arg(report.configurations)
+        .arg(report.paints)
+        .arg(report.hit_tests)
+        .arg(report.hot_path_allocations)
+        .arg(report.dropped_frames)
+        .arg(report.unpainted_events)
+        .arg(report.p50_latency_ms, 0, 'f', 3)
+        .arg(report.p99_latency_ms, 0, 'f', 3);
+}
@@ -0,0 +1,174 @@
+/**
+ * @file PieMenuTrace.h
+ * @brief Recording and replay of the pointer event stream of a PieMenu
+ *
+ * A trace stores the mouse and hover events a pie menu received together
+ * with their timestamps, the menu configuration at the start of the
+ * recording and every configuration change made while recording.
+ * Traces are written in a compact binary format and can be replayed
+ * offscreen at their original or at maximum speed to obtain paint,
+ * hit-test and latency figures for a reproducible interaction.
+ */
+
+#ifndef PIEMENUTRACE_H
+#define PIEMENUTRACE_H
+
+#include <QString>
+#include <QtGlobal>
+
+#include <functional>
+#include <vector>
+
+class PieMenu;
+
+/// \brief A recorded stream of pointer events received by a PieMenu
+class PieMenuTrace
+{
+public:
+    enum EventType : quint8 {
+        MOUSE_MOVE = 1,
+        MOUSE_PRESS = 2,
+        MOUSE_RELEASE = 3,
+        LEAVE = 4,
+        /// \brief The next configuration of configurations() takes effect
+        CONFIGURE = 5
+    };
+
+    /// \brief A concentric ring of pie buttons, see PieMenu::Ring
+    struct Ring {
+        quint8 count = 4;
+        double angle_offset = 0;
+    };
+
+    /// \brief Everything that defines what a pie menu paints, apart from icons and texts
+    struct Configuration {
+        quint32 pie_radius = 100;
+        quint8 stroke_width = 0;
+        qint32 base_angle = 45;
+        /// \brief The button rings from the innermost to the outermost
+        std::vector<Ring> rings;
+        quint8 close_button_radius = 35;
+        quint8 pin_button_radius = 13;
+        quint8 pie_icon_size = 20;
+        quint8 close_icon_size = 20;
+        quint8 pin_icon_size = 12;
+        bool show_pin_button = true;
+        bool pinned = false;
+        bool close_as_regular_button = false;
+        bool alternate_colors = true;
+        /// \brief The dispatch mode (PieMenu::DispatchMode)
+        quint8 dispatch_mode = 0;
+        /// \brief The enabled state of every pie button
+        std::vector<quint8> buttons_enabled;
+
+        /// \brief Constructs the default configuration with a single ring
+        Configuration();
+
+        /// \brief Returns the total amount of pie buttons in all rings
+        quint32 buttonCount() const;
+    };
+
+    /// \brief A single recorded event in widget coordinates
+    struct Event {
+        /// \brief Time since the start of the recording in microseconds
+        qint64 timestamp_us;
+        EventType type;
+        qint16 x;
+        qint16 y;
+        /// \brief The button that caused the event (Qt::MouseButton)
+        quint8 button;
+        /// \brief The button state during the event (Qt::MouseButtons)
+        quint8 buttons;
+    };
+
+    /// \brief Constructs an empty trace with the default configuration
+    PieMenuTrace();
+
+    /// \brief Removes all events and resets the recorded configurations
+    void clear();
+
+    /// \brief Appends an event to the trace
+    /// \param event: Reference to the event, timestamps must not decrease
+    void append(const Event& event) { trace_events.push_back(event); };
+
+    /// \brief Returns all recorded events in chronological order
+    const std::vector<Event>& events() const { return trace_events; };
+
+    /// \brief Sets the pie menu configuration at the start of the recording
+    void setInitialConfiguration(const Configuration& configuration) { trace_configurations.front() = configuration; };
+
+    /// \brief Appends a configuration change and the CONFIGURE event applying it
+    /// \param timestamp_us: Time of the change since the start of the recording in microseconds
+    /// \param configuration: Reference to the complete configuration after the change
+    void appendConfiguration(qint64 timestamp_us, const Configuration& configuration);
+
+    /// \brief Returns the initial configuration followed by one configuration per CONFIGURE event
+    const std::vector<Configuration>& configurations() const { return trace_configurations; };
+
+    /// \brief Writes the trace to a file
+    /// \param path: Reference to the path of the trace file
+    /// \return Whether the file could be written
+    bool save(const QString& path) const;
+
+    /// \brief Replaces the trace with the contents of a file
+    /// \param path: Reference to the path of the trace file
+    /// \return Whether the file could be read and has a supported format
+    bool load(const QString& path);
+
+protected:
+    /// \brief The recorded events
+    std::vector<Event> trace_events;
+
+    /// \brief The initial configuration and all later configuration changes
+    std::vector<Configuration> trace_configurations;
+};
+
+/// \brief Feeds a PieMenuTrace back into a pie menu and measures the result
+///
+/// The menu is shown and every replayed event is followed by running the event
+/// loop until the menu has painted, so the measurements cover the regular Qt
+/// update path. Use -platform offscreen to replay without a display.
+class PieMenuTraceReplay
+{
+public:
+    enum Speed {
+        ORIGINAL_SPEED,
+        MAXIMUM_SPEED
+    };
+
+    /// \brief Measurements of a single replay run
+    struct Report {
+        /// \brief Replayed pointer events, without configuration changes
+        quint64 events = 0;
+        /// \brief Replayed configuration changes
+        quint64 configurations = 0;
+        quint64 paints = 0;
+        quint64 hit_tests = 0;
+        /// \brief Heap allocations on the warmed up hover path, see PieMenu::Statistics
+        quint64 hot_path_allocations = 0;
+        /// \brief Frames whose event-to-paint latency exceeded the frame budget
+        quint64 dropped_frames = 0;
+        /// \brief Events after which the menu did not paint within the paint timeout
+        quint64 unpainted_events = 0;
+        double p50_latency_ms = 0;
+        double p99_latency_ms = 0;
+    };
+
+    /// \brief Called after a configuration has been applied, e.g. to set the icons of new buttons
+    using ConfigureCallback = std::function<void(PieMenu& menu)>;
+
+    /// \brief Replays a trace into the given pie menu
+    /// \param menu: Reference to the pie menu, its configuration is set from the trace
+    /// \param trace: Reference to the trace to be replayed
+    /// \param speed: Whether to keep the recorded timing or to run as fast as possible
+    /// \param configured: Called after every applied configuration, may be empty
+    /// \param frame_budget_ms: The latency above which a frame counts as dropped
+    /// \return The measurements of the run
+    static Report replay(PieMenu& menu, const PieMenuTrace& trace, Speed speed,
+                         const ConfigureCallback& configured = ConfigureCallback(), double frame_budget_ms = 1000.0 / 60.0);
+
+    /// \brief Formats a report as human readable text
+    static QString format(const Report& report);
+};
+
+#endif // PIEMENUTRACE_H
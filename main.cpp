@@ -16,11 +16,118 @@
 #include "MainWindow.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QDebug>
+
+#ifdef PIEMENU_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+
+#ifdef __GLIBC__
+// Interposes the C allocator for the whole program, so the allocations of Qt containers,
+// strings and the paint engine are counted as well as those of operator new, which uses malloc()
+extern "C" {
+    void* __libc_malloc(std::size_t size);
+    void* __libc_calloc(std::size_t count, std::size_t size);
+    void* __libc_realloc(void* memory, std::size_t size);
+
+    void* malloc(std::size_t size) noexcept {
+        PieMenu::countAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(std::size_t count, std::size_t size) noexcept {
+        PieMenu::countAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* memory, std::size_t size) noexcept {
+        PieMenu::countAllocation();
+        return __libc_realloc(memory, size);
+    }
+}
+#else
+// Without glibc, only the global operator new can be replaced portably
+void* operator new(std::size_t size) {
+    PieMenu::countAllocation();
+
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+#endif
+#endif
 
 int main(int argc, char *argv[])
 {
+    // deliver at most one pen move per frame to the pie menu
+    QCoreApplication::setAttribute(Qt::AA_CompressTabletEvents);
+
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+
+    QCommandLineOption record_option("record-trace", "Record the pie menu events to <file>.", "file");
+    QCommandLineOption replay_option("replay-trace", "Replay the pie menu events of <file> and print the measurements.", "file");
+    QCommandLineOption max_speed_option("max-speed", "Replay as fast as possible instead of at the recorded speed.");
+
+    parser.addOption(record_option);
+    parser.addOption(replay_option);
+    parser.addOption(max_speed_option);
+    parser.process(a);
+
+    if (parser.isSet(replay_option)) {
+        // run with -platform offscreen to replay without a display
+        PieMenuTrace trace;
+
+        if (!trace.load(parser.value(replay_option))) {
+            qCritical() << "Could not read trace file" << parser.value(replay_option);
+            return 1;
+        }
+
+        PieMenu menu;
+        menu.setCloseButtonIcon(QIcon(":/icons/close-line-icon.png"));
+        menu.setPinButtonIcon(QIcon(":/icons/pushpin-icon.png"));
+
+        // like the demo, every button gets the default icon whenever the amount of buttons changes
+        int32_t icon_count = 0;
+        const auto set_icons = [&icon_count](PieMenu& configured_menu) {
+            if (configured_menu.buttonCount() == icon_count) {
+                return;
+            }
+            icon_count = configured_menu.buttonCount();
+
+            for (int32_t i = 0; i < icon_count; i++) {
+                configured_menu.setButtonIcon(i, ":/icons/image-line-icon.png");
+            }
+        };
+
+        const auto report = PieMenuTraceReplay::replay(menu, trace, parser.isSet(max_speed_option)
+                                                                        ? PieMenuTraceReplay::MAXIMUM_SPEED
+                                                                        : PieMenuTraceReplay::ORIGINAL_SPEED,
+                                                       set_icons);
+        QTextStream(stdout) << PieMenuTraceReplay::format(report) << '\n';
+
+        if (report.hot_path_allocations != 0) {
+            qCritical() << "The hover path allocated" << report.hot_path_allocations << "times";
+            return 2;
+        }
+        return 0;
+    }
+
     MainWindow w;
+    w.setTraceFile(parser.value(record_option));
     w.show();
     return a.exec();
 }